@@ -0,0 +1,234 @@
+/** Copyright (c) 2026, Minutor contributors */
+// Micro benchmarks of the map pipeline stages:
+// region header, inflate, NBT parse, Chunk load, render, PNG export and
+// JSON parsing of definitions.
+// Run with "make bench" in the build directory of minutor.pro, results are
+// written as XML and CSV next to the bench executable.
+
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+#include <vector>
+#include "./regionfixture.h"
+#include "./biomeidentifier.h"
+#include "./blockidentifier.h"
+#include "./chunk.h"
+#include "./chunkrenderer.h"
+#include "./json.h"
+#include "./mapview.h"
+#include "./nbt.h"
+#include "./worldsave.h"
+#include "zlib/zlib.h"
+
+class Bench : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void initTestCase();
+
+  void regionHeader();
+  void inflate();
+  void nbtParse();
+  void chunkLoad();
+  void renderChunk_data();
+  void renderChunk();
+  void worldSave();
+  void jsonParse_data();
+  void jsonParse();
+
+ private:
+  bool loadDefinitions(const QString &file);
+  static QByteArray modPack(int blocks);
+  QString regionFile() const;
+
+  static const int FIXTURE_SIZE = 8;  // Chunks per side
+
+  QTemporaryDir dir;
+  QList<QByteArray> payloads;         // compressed Chunk data as on disk
+  QList<QSharedPointer<Chunk>> chunks;
+};
+
+bool Bench::loadDefinitions(const QString &file) {
+  QFile f(QString(DEFINITIONS_DIR) + "/" + file);
+  if (!f.open(QIODevice::ReadOnly))
+    return false;
+  std::unique_ptr<JSONData> def;
+  try {
+    def = JSON::parse(f.readAll());
+  } catch (JSONParseException e) {
+    return false;
+  }
+  QString type = def->at("type")->asString();
+  JSONArray *data = dynamic_cast<JSONArray*>(def->at("data"));
+  if (type == "flatblock")
+    BlockIdentifier::Instance().addDefinitions(data);
+  else if (type == "biome")
+    BiomeIdentifier::Instance().addDefinitions(data);
+  else
+    return false;
+  return true;
+}
+
+// flatblock definition in the style of a large mod pack:
+// many blocks, each with a few block state variants
+QByteArray Bench::modPack(int blocks) {
+  QByteArray json;
+  json += "{\n  \"name\": \"Bench Mod\",\n  \"type\": \"flatblock\",\n"
+          "  \"version\": \"1.0\",\n  \"data\": [\n";
+  for (int b = 0; b < blocks; b++) {
+    QByteArray name = "benchmod:block_" + QByteArray::number(b);
+    json += "    {\n      \"name\": \"" + name + "\",\n"
+            "      \"color\": \"#" +
+            QByteArray::number(0x100000 + b * 37 % 0xefffff, 16) + "\",\n";
+    if (b % 3 == 0)
+      json += "      \"transparent\": true,\n      \"alpha\": 0.5,\n";
+    json += "      \"variants\": [\n";
+    for (int v = 0; v < 4; v++) {
+      json += "        { \"blockstate\": \"facing=" + QByteArray::number(v) +
+              ",waterlogged=false\", \"color\": \"#40" +
+              QByteArray::number(10 + v * 20) + "ff\" }";
+      json += (v < 3) ? ",\n" : "\n";
+    }
+    json += "      ]\n    }";
+    json += (b < blocks - 1) ? ",\n" : "\n";
+  }
+  json += "  ]\n}\n";
+  return json;
+}
+
+QString Bench::regionFile() const {
+  return dir.path() + "/region/r.0.0.mca";
+}
+
+void Bench::initTestCase() {
+  QVERIFY(dir.isValid());
+  QVERIFY(RegionFixture::create(dir.path(), FIXTURE_SIZE));
+  QVERIFY(loadDefinitions("vanilla_blocks.json"));
+  QVERIFY(loadDefinitions("vanilla_biomes.json"));
+
+  for (int cz = 0; cz < FIXTURE_SIZE; cz++)
+    for (int cx = 0; cx < FIXTURE_SIZE; cx++)
+      payloads.append(RegionFixture::chunkPayload(cx, cz));
+
+  for (const QByteArray &payload : payloads) {
+    NBT nbt(reinterpret_cast<const uchar*>(payload.constData()));
+    QSharedPointer<Chunk> chunk(new Chunk());
+    QVERIFY(nbt.has("Level"));
+    chunk->load(nbt);
+    chunks.append(chunk);
+  }
+}
+
+void Bench::regionHeader() {
+  QFile f(regionFile());
+  QVERIFY(f.open(QIODevice::ReadOnly));
+  int found = 0;
+  QBENCHMARK {
+    found = 0;
+    uchar *header = f.map(0, 4096);
+    for (int offset = 0; offset < 4096; offset += 4) {
+      int coffset = (header[offset] << 16) | (header[offset + 1] << 8) |
+          header[offset + 2];
+      if (coffset != 0 && header[offset + 3] != 0)
+        found++;
+    }
+    f.unmap(header);
+  }
+  QCOMPARE(found, FIXTURE_SIZE * FIXTURE_SIZE);
+}
+
+void Bench::inflate() {
+  std::vector<char> out(1 << 20);
+  QBENCHMARK {
+    for (const QByteArray &payload : payloads) {
+      const uchar *raw = reinterpret_cast<const uchar*>(payload.constData());
+      uLongf size = out.size();
+      int length = (raw[0] << 24) | (raw[1] << 16) | (raw[2] << 8) | raw[3];
+      QCOMPARE(uncompress(reinterpret_cast<Bytef*>(out.data()), &size,
+                          raw + 5, length - 1), Z_OK);
+    }
+  }
+}
+
+void Bench::nbtParse() {
+  // NBT parses straight from the compressed payload, includes inflate
+  QBENCHMARK {
+    for (const QByteArray &payload : payloads) {
+      NBT nbt(reinterpret_cast<const uchar*>(payload.constData()));
+      QVERIFY(nbt.has("Level"));
+    }
+  }
+}
+
+void Bench::chunkLoad() {
+  QList<QSharedPointer<NBT>> parsed;
+  for (const QByteArray &payload : payloads)
+    parsed.append(QSharedPointer<NBT>(
+        new NBT(reinterpret_cast<const uchar*>(payload.constData()))));
+  QBENCHMARK {
+    for (const QSharedPointer<NBT> &nbt : parsed) {
+      Chunk chunk;
+      chunk.load(*nbt);
+    }
+  }
+}
+
+void Bench::renderChunk_data() {
+  QTest::addColumn<int>("flags");
+  const char *names[] = { "lighting", "mobspawn", "cave", "depth",
+                          "entities", "single", "biome" };
+  for (int flags = 0; flags < 128; flags++) {
+    if (flags & MapView::flgShowEntities)
+      continue;  // not used by the renderer
+    QStringList set;
+    for (int bit = 0; bit < 7; bit++)
+      if (flags & (1 << bit))
+        set.append(names[bit]);
+    QString name = set.isEmpty() ? QString("none") : set.join('+');
+    QTest::newRow(name.toUtf8().constData()) << flags;
+  }
+}
+
+void Bench::renderChunk() {
+  QFETCH(int, flags);
+  QBENCHMARK {
+    // export renders are complete and bypass the RenderCache
+    for (int i = 0; i < chunks.size(); i++) {
+      ChunkRenderer renderer(i % FIXTURE_SIZE, i / FIXTURE_SIZE, 255, flags);
+      renderer.setExport(i % FIXTURE_SIZE ? chunks[i - 1]
+                                          : QSharedPointer<Chunk>());
+      renderer.renderChunk(chunks[i]);
+    }
+  }
+}
+
+void Bench::worldSave() {
+  // complete export: load, render and PNG encoding of the fixture
+  MapView map;
+  map.setDimension(dir.path(), 1);
+  QString png = dir.path() + "/world.png";
+  QBENCHMARK {
+    WorldSave save(png, &map);
+    static_cast<QRunnable&>(save).run();  // synchronous, run() is protected
+  }
+  QVERIFY(QFile::exists(png));
+}
+
+void Bench::jsonParse_data() {
+  QTest::addColumn<QByteArray>("json");
+  QFile f(QString(DEFINITIONS_DIR) + "/vanilla_blocks.json");
+  QVERIFY(f.open(QIODevice::ReadOnly));
+  QTest::newRow("vanilla_blocks") << f.readAll();
+  QTest::newRow("modpack") << modPack(20000);
+}
+
+void Bench::jsonParse() {
+  QFETCH(QByteArray, json);
+  QBENCHMARK {
+    std::unique_ptr<JSONData> def = JSON::parse(json);
+    QVERIFY(def->at("data")->length() > 0);
+  }
+}
+
+QTEST_MAIN(Bench)
+#include "bench.moc"
@@ -0,0 +1,45 @@
+TEMPLATE = app
+TARGET = bench
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+CONFIG += c++14 console
+CONFIG -= app_bundle debug_and_release
+DESTDIR = $$OUT_PWD
+QT += widgets network testlib
+unix:LIBS += -lz
+unix:!macx:packagesExist(liburing) {
+  CONFIG += link_pkgconfig
+  PKGCONFIG += liburing
+  DEFINES += HAVE_LIBURING
+}
+DEFINES += DEFINITIONS_DIR=\\\"$$PWD/../definitions\\\"
+
+# the application sources without its main()
+APP_SOURCES = $$files(../*.cpp)
+APP_SOURCES -= ../main.cpp
+
+HEADERS += \
+    $$files(../*.h) \
+    regionfixture.h
+SOURCES += \
+    $$APP_SOURCES \
+    regionfixture.cpp \
+    bench.cpp
+FORMS += $$files(../*.ui)
+RESOURCES = ../minutor.qrc
+
+win32:SOURCES += ../zlib/adler32.c \
+		../zlib/compress.c \
+		../zlib/crc32.c \
+		../zlib/deflate.c \
+		../zlib/gzclose.c \
+		../zlib/gzlib.c \
+		../zlib/gzread.c \
+		../zlib/gzwrite.c \
+		../zlib/infback.c \
+		../zlib/inffast.c \
+		../zlib/inflate.c \
+		../zlib/inftrees.c \
+		../zlib/trees.c \
+		../zlib/uncompr.c \
+		../zlib/zutil.c
@@ -0,0 +1,204 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#include "./regionfixture.h"
+#include "zlib/zlib.h"
+
+namespace {
+
+// minimal writer for big endian NBT data
+class NbtWriter {
+ public:
+  void u8(quint8 v)   { data.append(static_cast<char>(v)); }
+  void u16(quint16 v) { u8(v >> 8); u8(v & 0xff); }
+  void u32(quint32 v) { u16(v >> 16); u16(v & 0xffff); }
+  void u64(quint64 v) { u32(v >> 32); u32(v & 0xffffffff); }
+  void str(const QString &s) {
+    QByteArray utf8 = s.toUtf8();
+    u16(utf8.size());
+    data.append(utf8);
+  }
+  void tag(quint8 type, const QString &name) { u8(type); str(name); }
+
+  void beginCompound(const QString &name) { tag(10, name); }
+  void end() { u8(0); }
+  void byteTag(const QString &name, qint8 v) { tag(1, name); u8(v); }
+  void intTag(const QString &name, qint32 v) { tag(3, name); u32(v); }
+  void stringTag(const QString &name, const QString &v) { tag(8, name); str(v); }
+  void beginList(const QString &name, quint8 type, int count) {
+    tag(9, name);
+    u8(type);
+    u32(count);
+  }
+  void intArrayTag(const QString &name, const QVector<qint32> &v) {
+    tag(11, name);
+    u32(v.size());
+    for (qint32 i : v) u32(i);
+  }
+  void longArrayTag(const QString &name, const QVector<quint64> &v) {
+    tag(12, name);
+    u32(v.size());
+    for (quint64 i : v) u64(i);
+  }
+  void byteArrayTag(const QString &name, const QByteArray &v) {
+    tag(7, name);
+    u32(v.size());
+    data.append(v);
+  }
+
+  QByteArray data;
+};
+
+// palette shared by all sections (16 entries -> 4 bits per block)
+const char *palette[16] = {
+  "minecraft:air",         "minecraft:stone",      "minecraft:dirt",
+  "minecraft:grass_block", "minecraft:water",      "minecraft:sand",
+  "minecraft:gravel",      "minecraft:oak_log",    "minecraft:oak_leaves",
+  "minecraft:coal_ore",    "minecraft:iron_ore",   "minecraft:bedrock",
+  "minecraft:glass",       "minecraft:snow",       "minecraft:torch",
+  "minecraft:cobblestone"
+};
+enum {
+  AIR, STONE, DIRT, GRASS, WATER, SAND, GRAVEL, LOG, LEAVES,
+  COAL, IRON, BEDROCK, GLASS, SNOW, TORCH, COBBLE
+};
+
+// deterministic hash used instead of a random generator
+quint32 hash(int x, int y, int z) {
+  quint32 h = x * 374761393u + y * 668265263u + z * 2246822519u;
+  h = (h ^ (h >> 13)) * 1274126177u;
+  return h ^ (h >> 16);
+}
+
+int terrainHeight(int x, int z) {
+  return 60 + (x * 3 + z * 5) % 17 + ((x / 7 + z / 5) % 3) * 4;
+}
+
+int blockAt(int x, int y, int z) {
+  int height = terrainHeight(x, z);
+  if (y == 0) return BEDROCK;
+  if (y > height) {
+    if (y <= 64) return WATER;
+    if (y == height + 1 && (hash(x, y, z) % 11) == 0) return SNOW;
+    return AIR;
+  }
+  // caves with torches for cave mode and mob spawn checks
+  if (y > 10 && y < 40 && (hash(x / 4, y / 4, z / 4) % 5) == 0)
+    return (hash(x, y, z) % 97) == 0 ? TORCH : AIR;
+  if (y == height) return height < 64 ? SAND : GRASS;
+  if (y > height - 4) return DIRT;
+  quint32 ore = hash(x, y, z) % 64;
+  if (ore == 0) return COAL;
+  if (ore == 1) return IRON;
+  if (ore == 2) return GRAVEL;
+  return STONE;
+}
+
+}  // namespace
+
+QByteArray RegionFixture::chunkNbt(int cx, int cz) {
+  NbtWriter w;
+  w.beginCompound("");
+  w.intTag("DataVersion", 1631);  // 1.13.2
+  w.beginCompound("Level");
+  w.intTag("xPos", cx);
+  w.intTag("zPos", cz);
+
+  QVector<qint32> biomes(256);
+  for (int i = 0; i < 256; i++)
+    biomes[i] = (cx + cz) & 1 ? 1 : 4;  // Plains or Forest
+  w.intArrayTag("Biomes", biomes);
+
+  int sections = 6;  // terrain never exceeds height 95
+  w.beginList("Sections", 10, sections);
+  for (int s = 0; s < sections; s++) {
+    w.byteTag("Y", s);
+    w.beginList("Palette", 10, 16);
+    for (int p = 0; p < 16; p++) {
+      w.stringTag("Name", palette[p]);
+      w.end();
+    }
+    // 16 blocks of 4 bits per long
+    QVector<quint64> states(256, 0);
+    QByteArray light(2048, 0);
+    for (int i = 0; i < 4096; i++) {
+      int x = i & 0x0f, z = (i >> 4) & 0x0f, y = (s << 4) | (i >> 8);
+      quint64 block = blockAt(cx * 16 + x, y, cz * 16 + z);
+      states[i >> 4] |= block << ((i & 0x0f) * 4);
+      if (block == TORCH)
+        light[i >> 1] = light[i >> 1] | (14 << ((i & 1) * 4));
+    }
+    w.longArrayTag("BlockStates", states);
+    w.byteArrayTag("BlockLight", light);
+    w.end();
+  }
+
+  // a few mobs for the Entity overlay
+  w.beginList("Entities", 10, 4);
+  for (int e = 0; e < 4; e++) {
+    int x = cx * 16 + e * 4, z = cz * 16 + e * 3;
+    w.stringTag("id", e & 1 ? "minecraft:zombie" : "minecraft:cow");
+    w.beginList("Pos", 6, 3);
+    double pos[3] = { x + 0.5, terrainHeight(x, z) + 1.0, z + 0.5 };
+    for (double v : pos) {
+      quint64 bits;
+      memcpy(&bits, &v, sizeof(bits));
+      w.u64(bits);
+    }
+    w.end();
+  }
+
+  w.end();  // Level
+  w.end();  // root
+  return w.data;
+}
+
+QByteArray RegionFixture::chunkPayload(int cx, int cz) {
+  QByteArray nbt = chunkNbt(cx, cz);
+  uLongf size = compressBound(nbt.size());
+  QByteArray compressed(size, 0);
+  compress2(reinterpret_cast<Bytef *>(compressed.data()), &size,
+            reinterpret_cast<const Bytef *>(nbt.constData()), nbt.size(), 6);
+  compressed.resize(size);
+
+  QByteArray payload;
+  quint32 length = size + 1;
+  payload.append(static_cast<char>(length >> 24));
+  payload.append(static_cast<char>((length >> 16) & 0xff));
+  payload.append(static_cast<char>((length >> 8) & 0xff));
+  payload.append(static_cast<char>(length & 0xff));
+  payload.append(static_cast<char>(2));  // zlib
+  payload.append(compressed);
+  return payload;
+}
+
+bool RegionFixture::create(const QString &path, int size) {
+  if (!QDir().mkpath(path + "/region"))
+    return false;
+  QFile f(path + "/region/r.0.0.mca");
+  if (!f.open(QIODevice::WriteOnly))
+    return false;
+
+  QByteArray header(8192, 0);  // locations and timestamps
+  QByteArray sectors;
+  int sector = 2;
+  for (int cz = 0; cz < size; cz++) {
+    for (int cx = 0; cx < size; cx++) {
+      QByteArray payload = chunkPayload(cx, cz);
+      int count = (payload.size() + 4095) / 4096;
+      payload.append(QByteArray(count * 4096 - payload.size(), 0));
+      int offset = 4 * ((cx & 31) + (cz & 31) * 32);
+      header[offset + 0] = static_cast<char>(sector >> 16);
+      header[offset + 1] = static_cast<char>((sector >> 8) & 0xff);
+      header[offset + 2] = static_cast<char>(sector & 0xff);
+      header[offset + 3] = static_cast<char>(count);
+      sectors.append(payload);
+      sector += count;
+    }
+  }
+  f.write(header);
+  f.write(sectors);
+  f.close();
+  return true;
+}
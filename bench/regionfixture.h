@@ -0,0 +1,24 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef BENCH_REGIONFIXTURE_H_
+#define BENCH_REGIONFIXTURE_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+// generates a reproducible world with one Region file of synthetic Chunks
+// (1.13 Chunk format, deterministic terrain without any random source)
+class RegionFixture {
+ public:
+  // creates "<path>/region/r.0.0.mca" with size x size Chunks
+  static bool create(const QString &path, int size);
+
+  // compressed payload of one Chunk, as stored in a Region file
+  // (4 byte length, compression type, zlib data)
+  static QByteArray chunkPayload(int cx, int cz);
+
+ private:
+  static QByteArray chunkNbt(int cx, int cz);
+};
+
+#endif  // BENCH_REGIONFIXTURE_H_
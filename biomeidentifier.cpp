@@ -7,6 +7,7 @@ Copyright (c) 2016, EtlamGit
 #include <cmath>
 
 #include "./biomeidentifier.h"
+#include "./definitioncache.h"
 #include "./json.h"
 #include "./clamp.h"
 
@@ -299,6 +300,56 @@ int BiomeIdentifier::addDefinitions(JSONArray *defs, int pack) {
   return pack;
 }
 
+int BiomeIdentifier::addDefinitions(const DefinitionCache &cache,
+                                    const CachedTable &table, int pack) {
+  if (pack == -1) {
+    pack = packs.length();
+    packs.append(QList<BiomeInfo *>());
+  }
+
+  const CachedBiome *records = cache.getRecords<CachedBiome>(table);
+  for (quint32 i = 0; i < table.count; i++) {
+    const CachedBiome &b = records[i];
+    BiomeInfo *biome = new BiomeInfo();
+    biome->enabled = true;
+    biome->id = b.id;
+    biome->name = cache.getString(b.name);
+    biome->alpha = b.alpha;
+    biome->temperature = b.temperature;
+    biome->humidity = b.humidity;
+    biome->watermodifier = QColor::fromRgba(b.watermodifier);
+    biome->enabledwatermodifier = b.enabledwatermodifier;
+    for (int c = 0; c < 16; c++)
+      biome->colors[c] = QColor::fromRgba(b.colors[c]);
+    packs[pack].append(biome);
+  }
+
+  updateBiomeDefinition();
+  return pack;
+}
+
+CachedTable BiomeIdentifier::compileDefinitions(int pack,
+                                                DefinitionCache *cache) const {
+  QVector<CachedBiome> records;
+  if (pack >= 0) {
+    for (const BiomeInfo *biome : packs[pack]) {
+      CachedBiome b;
+      memset(&b, 0, sizeof(b));
+      b.id = biome->id;
+      b.name = cache->addString(biome->name);
+      b.alpha = biome->alpha;
+      b.temperature = biome->temperature;
+      b.humidity = biome->humidity;
+      b.watermodifier = biome->watermodifier.rgba();
+      b.enabledwatermodifier = biome->enabledwatermodifier;
+      for (int c = 0; c < 16; c++)
+        b.colors[c] = biome->colors[c].rgba();
+      records.append(b);
+    }
+  }
+  return cache->addRecords(records);
+}
+
 void BiomeIdentifier::updateBiomeDefinition()
 {
   // start from scratch
@@ -7,6 +7,8 @@
 #include <QString>
 #include <QColor>
 class JSONArray;
+class DefinitionCache;
+struct CachedTable;
 
 
 class BiomeInfo {
@@ -48,6 +50,9 @@ class BiomeIdentifier {
   static BiomeIdentifier &Instance();
 
   int addDefinitions(JSONArray *, int pack = -1);
+  int addDefinitions(const DefinitionCache &cache, const CachedTable &table,
+                     int pack = -1);
+  CachedTable compileDefinitions(int pack, DefinitionCache *cache) const;
   void enableDefinitions(int id);
   void disableDefinitions(int id);
   void updateBiomeDefinition();
@@ -6,6 +6,7 @@
 #include <cmath>
 
 #include "./blockidentifier.h"
+#include "./definitioncache.h"
 #include "./json.h"
 
 static BlockInfo unknownBlock;
@@ -264,6 +265,10 @@ void BlockIdentifier::parseDefinition(JSONObject *b, BlockInfo *parent,
                          "Failed to add Block from definition file, as it might be a duplicate\nor generates the same hash as an already existing Block." ,
                          QMessageBox::Cancel, QMessageBox::Cancel);
   }
+  insertBlock(block, hid, pack);
+}
+
+void BlockIdentifier::insertBlock(BlockInfo *block, uint hid, int pack) {
   blocks.insert(hid, block);
   packs[pack].append(block);
 
@@ -273,3 +278,63 @@ void BlockIdentifier::parseDefinition(JSONObject *b, BlockInfo *parent,
     blocks.insert(0, block);
   }
 }
+
+int BlockIdentifier::addDefinitions(const DefinitionCache &cache,
+                                    const CachedTable &table, int pack) {
+  if (pack == -1) {
+    pack = packs.length();
+    packs.append(QList<BlockInfo*>());
+  }
+  const CachedBlock *records = cache.getRecords<CachedBlock>(table);
+  for (quint32 i = 0; i < table.count; i++) {
+    const CachedBlock &b = records[i];
+    BlockInfo *block = new BlockInfo();
+    block->setName(cache.getString(b.name));
+    block->enabled = true;
+    block->blockstate = cache.getString(b.blockstate);
+    block->alpha = b.alpha;
+    block->variants = b.variants;
+    block->transparent = b.transparent;
+    block->liquid = b.liquid;
+    block->rendernormal = b.rendernormal;
+    block->providepower = b.providepower;
+    block->spawninside = b.spawninside;
+    for (int c = 0; c < 16; c++)
+      block->colors[c] = QColor::fromRgba(b.colors[c]);
+    block->setBiomeGrass(b.grass);
+    block->setBiomeFoliage(b.foliage);
+    insertBlock(block, b.hid, pack);
+  }
+  return pack;
+}
+
+CachedTable BlockIdentifier::compileDefinitions(int pack,
+                                                DefinitionCache *cache) {
+  QVector<CachedBlock> records;
+  if (pack >= 0) {
+    // keep insertion order, later duplicates have to win again
+    for (BlockInfo *block : packs[pack]) {
+      CachedBlock b;
+      memset(&b, 0, sizeof(b));
+      const QString &name = block->getName();
+      b.name = cache->addString(name);
+      b.blockstate = cache->addString(block->blockstate);
+      b.hid = qHash(name);
+      if (!block->blockstate.isEmpty())
+        b.hid = qHash(name + ":" + block->blockstate);
+      for (int c = 0; c < 16; c++)
+        b.colors[c] = block->colors[c].rgba();
+      b.alpha = block->alpha;
+      b.variants = block->variants;
+      b.transparent = block->transparent;
+      b.liquid = block->liquid;
+      b.rendernormal = block->rendernormal;
+      b.providepower = block->providepower;
+      b.spawninside = block->spawninside;
+      b.grass = block->biomeGrass();
+      b.foliage = block->biomeFoliage();
+      records.append(b);
+    }
+  }
+  return cache->addRecords(records);
+}
@@ -10,6 +10,8 @@
 
 class JSONArray;
 class JSONObject;
+class DefinitionCache;
+struct CachedTable;
 
 
 class BlockInfo {
@@ -74,6 +76,9 @@ class BlockIdentifier {
   static BlockIdentifier &Instance();
 
   int  addDefinitions(JSONArray *, int pack = -1);
+  int  addDefinitions(const DefinitionCache &cache, const CachedTable &table,
+                      int pack = -1);
+  CachedTable compileDefinitions(int pack, DefinitionCache *cache);
   void enableDefinitions(int id);
   void disableDefinitions(int id);
   BlockInfo &getBlockInfo(uint hid);
@@ -87,6 +92,7 @@ class BlockIdentifier {
   BlockIdentifier &operator=(const BlockIdentifier &);
 
   void parseDefinition(JSONObject *block, BlockInfo *parent, int pack);
+  void insertBlock(BlockInfo *block, uint hid, int pack);
   QMap<uint, BlockInfo*>    blocks;
   QList<QList<BlockInfo*> > packs;
 };
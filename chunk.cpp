@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "./chunk.h"
+#include "./perfcounters.h"
 #include "./flatteningconverter.h"
 #include "./blockidentifier.h"
 
@@ -21,8 +22,19 @@ quint16 getBits(const unsigned char *data, int pos, int n) {
 
 
 
+static quint64 edgeKey(int depth, int flags, int generation) {
+  return quint64(depth & 0xffff) | (quint64(flags & 0xffff) << 16) |
+         (quint64(quint32(generation)) << 32);
+}
+
 Chunk::Chunk() {
   loaded = false;
+  rendering.store(0);
+  edgeSequence.store(0);
+  edgeSettings.store(edgeKey(-1, 0, 0));  // no render yet
+  edgeHeights[0].store(0);
+  edgeHeights[1].store(0);
+  parsedParts.store(0);
 }
 
 Chunk::~Chunk() {
@@ -42,11 +54,15 @@ Chunk::~Chunk() {
 }
 
 
-void Chunk::load(const NBT &nbt) {
+void Chunk::load(const NBT &nbt, int parts) {
+  PerfScope scope(PerfCounters::stgChunk);
   renderedAt = -1;  // impossible.
   renderedFlags = 0;  // no flags
-  for (int i = 0; i < 16; i++)
+  renderedGeneration = 0;
+  for (int i = 0; i < 16; i++) {
     this->sections[i] = NULL;
+    westEdge[i] = -1;
+  }
   highest = 0;
 
   int version = 0;
@@ -92,34 +108,25 @@ void Chunk::load(const NBT &nbt) {
           loadSection1343(cs, section);
         }
 
+        cs->buildMasks();
         this->sections[idx] = cs;
       }
     }
   }
 
   // parse Structures that start in this Chunk
-  if (version >= 1519) {
-    if (level->has("Structures")) {
-      auto nbtListStructures = level->at("Structures");
-      auto structurelist     = GeneratedStructure::tryParseChunk(nbtListStructures);
-      for (auto it = structurelist.begin(); it != structurelist.end(); ++it) {
-        emit structureFound(*it);
-      }
-    }
-  }
-
-  loaded = true;
+  if (parts & partStructures)
+    loadStructures(level, version);
+  else
+    scanStructures(level, version);
 
   // parse Entities
-  if (level->has("Entities")) {
-    auto entitylist = level->at("Entities");
-    int numEntities = entitylist->length();
-    for (int i = 0; i < numEntities; ++i) {
-      auto e = Entity::TryParse(entitylist->at(i));
-      if (e)
-        entities.insertMulti(e->type(), e);
-    }
-  }
+  if (parts & partEntities)
+    loadEntities(level);
+
+  parsedParts.store(parts);
+
+  loaded = true;
 
   // check for the highest block in this chunk
   // todo: use highmap from stored NBT data
@@ -135,6 +142,112 @@ void Chunk::load(const NBT &nbt) {
   }
 }
 
+int Chunk::missingParts() const {
+  return partAll & ~parsedParts.loadAcquire();
+}
+
+// parse parts of the NBT data that were skipped in load()
+void Chunk::loadMissing(int parts, const QByteArray &data) {
+  partsMutex.lock();
+  parts &= missingParts();
+  if (!parts || data.isEmpty()) {
+    partsMutex.unlock();
+    return;
+  }
+
+  NBT nbt(reinterpret_cast<const uchar*>(data.constData()));
+  int version = 0;
+  if (nbt.has("DataVersion"))
+    version = nbt.at("DataVersion")->toInt();
+  const Tag * level = nbt.at("Level");
+
+  if (parts & partStructures)
+    loadStructures(level, version);
+  if (parts & partEntities)
+    loadEntities(level);
+
+  // publish the parts only after they are complete
+  parsedParts.fetchAndOrOrdered(parts);
+  partsMutex.unlock();
+}
+
+void Chunk::publishEastEdge() {
+  quint64 heights[2] = {0, 0};
+  for (int z = 0; z < 16; z++)
+    heights[z >> 3] |= quint64(depth[z * 16 + 15]) << ((z & 7) * 8);
+  edgeSequence.fetchAndAddOrdered(1);
+  edgeSettings.storeRelease(edgeKey(renderedAt, renderedFlags,
+                                    renderedGeneration));
+  edgeHeights[0].storeRelease(heights[0]);
+  edgeHeights[1].storeRelease(heights[1]);
+  edgeSequence.fetchAndAddRelease(1);
+}
+
+// false when not rendered with the given settings (or busy being written)
+bool Chunk::readEastEdge(int depth, int flags, int generation,
+                         int *heights) const {
+  for (int attempt = 0; attempt < 4; attempt++) {
+    int before = edgeSequence.loadAcquire();
+    if (before & 1)
+      continue;
+    quint64 settings = edgeSettings.loadAcquire();
+    quint64 words[2] = { edgeHeights[0].loadAcquire(),
+                         edgeHeights[1].loadAcquire() };
+    if (edgeSequence.loadAcquire() != before)
+      continue;
+    if (settings != edgeKey(depth, flags, generation))
+      return false;
+    for (int z = 0; z < 16; z++)
+      heights[z] = (words[z >> 3] >> ((z & 7) * 8)) & 0xff;
+    return true;
+  }
+  return false;
+}
+
+void Chunk::loadEntities(const Tag *level) {
+  if (level->has("Entities")) {
+    auto entitylist = level->at("Entities");
+    int numEntities = qMin(entitylist->length(), 65536);
+    entities.reserve(numEntities);
+    for (int i = 0; i < numEntities; ++i) {
+      EntityRecord e;
+      if (Entity::TryParse(entitylist->at(i), &e)) {
+        e.index = i;
+        entities.append(e);
+      }
+    }
+    entities.squeeze();
+  }
+}
+
+void Chunk::loadStructures(const Tag *level, int version) {
+  if (version >= 1519) {
+    if (level->has("Structures")) {
+      auto nbtListStructures = level->at("Structures");
+      auto structurelist     = GeneratedStructure::tryParseChunk(nbtListStructures);
+      for (auto it = structurelist.begin(); it != structurelist.end(); ++it) {
+        emit structureFound(*it);
+      }
+    }
+  }
+}
+
+// only report the types of Structures starting here (to populate the menu)
+void Chunk::scanStructures(const Tag *level, int version) {
+  if (version >= 1519) {
+    const Tag_Compound * starts = dynamic_cast<const Tag_Compound*>(
+        level->at("Structures")->at("Starts"));
+    if (starts) {
+      for (auto &key : starts->keys()) {
+        QString id = starts->at(key)->at("id")->toString();
+        if (!id.isEmpty() && id != "INVALID")
+          emit structureTypeFound("Structure." + id,
+                                  GeneratedStructure::getColor(id));
+      }
+    }
+  }
+}
+
 // supported DataVersions:
 //    0 = 1.8 and below
 //
@@ -252,6 +365,88 @@ void Chunk::loadSection1519(ChunkSection *cs, const Tag *section) {
 }
 
 
+// classify all blocks once, so the renderer can skip invisible ones quickly
+void ChunkSection::buildMasks() {
+  BlockIdentifier &bi = BlockIdentifier::Instance();
+  // look up each distinct block value only once
+  // (legacy sections share the large converter palette -> use a hash)
+  // state: bit 0 = classified, other bits = properties of the block
+  enum {
+    stKnown       = 1,
+    stVisible     = 2,
+    stTransparent = 4,
+    stSolidTop    = 8,
+    stNormalCube  = 16,
+    stSpawnInside = 32,
+    stLiquid      = 64,
+    stBedrock     = 128
+  };
+  QVector<quint8> known(paletteLength, 0);
+  QHash<quint16, quint8> knownLegacy;
+  memset(visible,     0, sizeof(visible));
+  memset(transparent, 0, sizeof(transparent));
+  memset(solidTop,    0, sizeof(solidTop));
+  memset(normalCube,  0, sizeof(normalCube));
+  memset(spawnInside, 0, sizeof(spawnInside));
+  memset(liquid,      0, sizeof(liquid));
+  memset(bedrock,     0, sizeof(bedrock));
+  memset(dark,        0, sizeof(dark));
+  for (int i = 0; i < 4096; i++) {
+    quint16 value = blocks[i];
+    quint8 &state = (paletteLength > 0) ? known[value] : knownLegacy[value];
+    if (state == 0) {
+      BlockInfo &block = bi.getBlockInfo(palette[value].hid);
+      state = stKnown;
+      if (block.alpha != 0.0)                   state |= stVisible;
+      if (block.transparent)                    state |= stTransparent;
+      if (block.doesBlockHaveSolidTopSurface()) state |= stSolidTop;
+      if (block.isBlockNormalCube())            state |= stNormalCube;
+      if (block.spawninside)                    state |= stSpawnInside;
+      if (block.isLiquid())                     state |= stLiquid;
+      if (block.isBedrock())                    state |= stBedrock;
+    }
+    int column = i & 0xff;
+    quint16 bit = 1 << (i >> 8);
+    if (state & stVisible)     visible[column]     |= bit;
+    if (state & stTransparent) transparent[column] |= bit;
+    if (state & stSolidTop)    solidTop[column]    |= bit;
+    if (state & stNormalCube)  normalCube[column]  |= bit;
+    if (state & stSpawnInside) spawnInside[column] |= bit;
+    if (state & stLiquid)      liquid[column]      |= bit;
+    if (state & stBedrock)     bedrock[column]     |= bit;
+    if (getBlockLight(column, i >> 8) < 8)
+      dark[column] |= bit;
+  }
+}
+
+int Chunk::nextVisible(int offset, int y) const {
+  for (int sec = y >> 4; sec >= 0; sec--) {
+    const ChunkSection *section = sections[sec];
+    if (!section)
+      continue;
+    quint16 mask = section->visible[offset];
+    if (sec == (y >> 4))
+      mask &= (2 << (y & 0x0f)) - 1;  // only at or below y
+    if (mask)
+      return (sec << 4) + 15 - qCountLeadingZeroBits(mask);
+  }
+  return -1;
+}
+
+quint16 Chunk::transparentBelow(int offset, int y) const {
+  if (y <= 0)
+    return 0;
+  // combine the two sections that may contain the 16 blocks
+  int sec = (y - 1) >> 4;
+  quint32 column = 0;  // bit n = height (sec-1)*16 + n
+  if (sections[sec])
+    column |= quint32(sections[sec]->transparent[offset]) << 16;
+  if (sec > 0 && sections[sec - 1])
+    column |= sections[sec - 1]->transparent[offset];
+  int top = ((y - 1) & 0x0f) + 16;  // position of height y-1
+  return (column >> (top - 15)) & 0xffff;
+}
+
 const PaletteEntry & ChunkSection::getPaletteEntry(int x, int y, int z) {
   int xoffset = x;
   int yoffset = (y & 0x0f) << 8;
@@ -19,6 +19,7 @@ class ChunkSection {
   quint8 getSkyLight(int offset, int y);
   quint8 getBlockLight(int x, int y, int z);
   quint8 getBlockLight(int offset, int y);
+  void buildMasks();
 
   PaletteEntry *palette;
   int        paletteLength;
@@ -26,6 +27,17 @@ class ChunkSection {
   quint16 blocks[16*16*16];
 //quint8  skyLight[16*16*16/2];   // not needed in Minutor
   quint8  blockLight[16*16*16/2];
+
+  // per column bit masks (bit n = block at height n inside this section)
+  quint16 visible[16*16];   // blocks that are not fully transparent
+  quint16 transparent[16*16];  // blocks flagged as transparent (cave mode)
+  // properties for mob spawning (see MobSpawn)
+  quint16 solidTop[16*16];
+  quint16 normalCube[16*16];
+  quint16 spawnInside[16*16];
+  quint16 liquid[16*16];
+  quint16 bedrock[16*16];
+  quint16 dark[16*16];         // block light below 8
 };
 
 
@@ -33,35 +45,69 @@ class Chunk : public QObject {
   Q_OBJECT
 
  public:
+  // optional parts of the NBT data, only parsed when needed by an overlay
+  enum {
+    partEntities   = 1,
+    partStructures = 2,
+    partAll        = partEntities | partStructures
+  };
+
   Chunk();
   ~Chunk();
-  void load(const NBT &nbt);
+  void load(const NBT &nbt, int parts = partAll);
+  // first visible block at or below y in the given column (-1 if none)
+  int nextVisible(int offset, int y) const;
+  // transparent blocks in the 16 blocks below y (bit n = height y-16+n)
+  quint16 transparentBelow(int offset, int y) const;
+  int missingParts() const;
+  // parse skipped parts from the compressed NBT data (in a worker thread,
+  // the view only reads a part after it is flagged as parsed)
+  void loadMissing(int parts, const QByteArray &data);
+  // eastern column of the current render for renderers of the neighbour,
+  // published by the owner of the render and read without locking
+  void publishEastEdge();
+  bool readEastEdge(int depth, int flags, int generation, int *heights) const;
 
  signals:
   void structureFound(QSharedPointer<GeneratedStructure> structure);
+  void structureTypeFound(QString type, QColor color);
 
  protected:
   void loadSection1343(ChunkSection *cs, const Tag *section);
   void loadSection1519(ChunkSection *cs, const Tag *section);
+  void loadEntities(const Tag *level);
+  void loadStructures(const Tag *level, int version);
+  void scanStructures(const Tag *level, int version);
 
 
-  typedef QMap<QString, QSharedPointer<OverlayItem>> EntityMap;
-
   quint32 biomes[16*16];
   int highest;
   ChunkSection *sections[16];
   int renderedAt;
   int renderedFlags;
+  int renderedGeneration;
+  qint16 westEdge[16];  // neighbour's heights the western edge was shaded
+                       // with (-1 = unknown)
   bool loaded;
+  QAtomicInt rendering;  // a render job owns image and depth
   uchar image[16 * 16 * 4];  // cached render
   uchar depth[16 * 16];
-  EntityMap entities;
+  // snapshot of the eastern column (sequence is odd while it is written)
+  QAtomicInt edgeSequence;
+  QAtomicInteger<quint64> edgeSettings;    // see edgeKey()
+  QAtomicInteger<quint64> edgeHeights[2];  // 8 heights per word
+  QVector<EntityRecord> entities;
+  QAtomicInt parsedParts;
+  QMutex partsMutex;  // serializes loadMissing()
   int chunkX;
   int chunkZ;
   friend class MapView;
   friend class ChunkRenderer;
   friend class ChunkCache;
+  friend class RenderCache;
+  friend class MobSpawn;
   friend class WorldSave;
+  friend class Entity;
 };
 
 #endif  // CHUNK_H_
@@ -1,7 +1,12 @@
 /** Copyright (c) 2013, Sean Kasun */
+#include <QSettings>
 
 #include "./chunkcache.h"
 #include "./chunkloader.h"
+#include "./rendercache.h"
+#include "./perfcounters.h"
+#include "./workerpools.h"
+#include "./regionreader.h"
 
 #if defined(__unix__) || defined(__unix) || defined(unix)
 #include <unistd.h>
@@ -18,7 +23,7 @@ uint qHash(const ChunkID &c) {
   return (c.cx << 16) ^ (c.cz & 0xffff);  // safe way to hash a pair of integers
 }
 
-ChunkCache::ChunkCache() {
+ChunkCache::ChunkCache() : renderSettings(-1) {
   int chunks = 10000;  // 10% more than 1920x1200 blocks
 #if defined(__unix__) || defined(__unix) || defined(unix)
 #ifdef _SC_AVPHYS_PAGES
@@ -35,17 +40,23 @@ ChunkCache::ChunkCache() {
 #endif
   cache.setMaxCost(chunks);
   maxcache = 2 * chunks;  // most chunks are less than half filled with sections
+  rawCache.setMaxCost(RAW_CACHE_MB * 1024);
 
-  // determain optimal thread pool size for "loading"
-  // as this contains disk access, use less than number of cores
-  int tmax = loaderThreadPool.maxThreadCount();
-  loaderThreadPool.setMaxThreadCount(tmax / 2);
+  // asynchronous reads are experimental, selected once at startup
+  bool async = QSettings().value("asyncio", false).toBool();
+  reader = RegionReader::create(async ? RegionReader::backendUring
+                                      : RegionReader::backendThreads);
 
   qRegisterMetaType<QSharedPointer<GeneratedStructure>>("QSharedPointer<GeneratedStructure>");
+
+  connect(&watcher, SIGNAL(directoryChanged(const QString &)),
+          this,     SLOT  (regionFolderChanged(const QString &)));
+  connect(&watcher, SIGNAL(fileChanged(const QString &)),
+          this,     SLOT  (regionFileChanged(const QString &)));
 }
 
 ChunkCache::~ChunkCache() {
-  loaderThreadPool.waitForDone();
+  delete reader;
 }
 
 ChunkCache& ChunkCache::Instance() {
@@ -54,19 +65,44 @@ ChunkCache& ChunkCache::Instance() {
 }
 
 void ChunkCache::clear() {
-  QThreadPool::globalInstance()->waitForDone();
+  // decoders write into the Chunks that are dropped here; running reads
+  // are not waited for (they might take long on slow drives), their
+  // results are dropped unless they are for the current path, where the
+  // data is still valid (changed Region files are handled separately)
+  WorkerPools::Instance().waitForDone(WorkerPools::stageCPU);
   mutex.lock();
   cache.clear();
+  rawCache.clear();
+  missingRegions.clear();
+  regionChunks.clear();
   mutex.unlock();
+  RenderCache::Instance().clear();
 }
 
 void ChunkCache::setPath(QString path) {
-  if (this->path != path)
-    clear();
+  // switch first, so loaders of the old path can no longer store results
+  bool changed = (this->path != path);
+  mutex.lock();
   this->path = path;
+  mutex.unlock();
+  if (changed)
+    clear();
+
+  // watch for Region files appearing or changing on disk
+  if (!watcher.files().isEmpty())
+    watcher.removePaths(watcher.files());
+  if (!watcher.directories().isEmpty())
+    watcher.removePaths(watcher.directories());
+  if (QDir(path).exists())
+    watcher.addPath(path);
+  if (QDir(path + "/region").exists())
+    watcher.addPath(path + "/region");
 }
 QString ChunkCache::getPath() const {
-  return path;
+  mutex.lock();
+  QString current = path;  // also read by loader threads
+  mutex.unlock();
+  return current;
 }
 
 int ChunkCache::getCost() const {
@@ -98,22 +134,123 @@ QSharedPointer<Chunk> ChunkCache::fetch(int cx, int cz) {
   mutex.unlock();
   if (p_chunk != NULL ) {
     QSharedPointer<Chunk> chunk(*p_chunk);
-    if (chunk->loaded)
+    if (chunk->loaded) {
+      PerfCounters::Instance().add(PerfCounters::cntCacheHit);
       return chunk;
+    }
+    PerfCounters::Instance().add(PerfCounters::cntCacheLoading);
     return QSharedPointer<Chunk>(NULL);  // we're loading this chunk, or it's blank.
   }
+  // Chunk is known to be absent on disk -> no need to try loading it
+  if (isKnownEmpty(cx, cz))
+    return QSharedPointer<Chunk>(NULL);
   // launch background process to load this chunk
-  p_chunk = new QSharedPointer<Chunk>(new Chunk());
+  PerfCounters::Instance().add(PerfCounters::cntCacheMiss);
+  startLoader(cx, cz, 0);
+  return QSharedPointer<Chunk>(NULL);
+}
+
+void ChunkCache::prefetch(int cx, int cz) {
+  ChunkID id(cx, cz);
+  mutex.lock();
+  bool known = cache.contains(id);
+  // never evict Chunks just to load speculative ones
+  bool full  = (cache.totalCost() >= cache.maxCost());
+  mutex.unlock();
+  if (known || full || isKnownEmpty(cx, cz))
+    return;
+  // queued behind all Chunks that are requested for display
+  startLoader(cx, cz, -1);
+}
+
+void ChunkCache::startLoader(int cx, int cz, int priority) {
+  ChunkID id(cx, cz);
+  QSharedPointer<Chunk> * p_chunk = new QSharedPointer<Chunk>(new Chunk());
   connect(p_chunk->data(), SIGNAL(structureFound(QSharedPointer<GeneratedStructure>)),
           this,            SLOT  (routeStructure(QSharedPointer<GeneratedStructure>)));
+  connect(p_chunk->data(), SIGNAL(structureTypeFound(QString, QColor)),
+          this,            SIGNAL(structureTypeFound(QString, QColor)));
   mutex.lock();
+  int before = cache.count();
   cache.insert(id, p_chunk);    // non-const operation !
+  int evicted = before + 1 - cache.count();
   mutex.unlock();
-  ChunkLoader *loader = new ChunkLoader(path, cx, cz);
-  connect(loader, SIGNAL(loaded(int, int)),
-          this,   SLOT(gotChunk(int, int)));
-  loaderThreadPool.start(loader);
-  return QSharedPointer<Chunk>(NULL);
+  if (evicted > 0)
+    PerfCounters::Instance().add(PerfCounters::cntCacheEvict, evicted);
+
+  // compressed Chunk data might still be in memory
+  QByteArray data;
+  if (fetchRaw(cx, cz, &data)) {
+    startDecoder(path, cx, cz, data, priority);
+    return;
+  }
+  reader->request(path, cx, cz, priority);
+}
+
+void ChunkCache::chunkRead(const QString &path, int cx, int cz,
+                           const QByteArray &data, int priority) {
+  if (path != getPath())
+    return;  // the Chunk entry belongs to another world by now
+  storeRaw(path, cx, cz, data);
+  startDecoder(path, cx, cz, data, priority);
+}
+
+void ChunkCache::chunkUnavailable(int cx, int cz) {
+  QMetaObject::invokeMethod(this, "gotChunk", Qt::QueuedConnection,
+                            Q_ARG(int, cx), Q_ARG(int, cz));
+}
+
+void ChunkCache::startDecoder(const QString &path, int cx, int cz,
+                              const QByteArray &data, int priority) {
+  ChunkDecoder *decoder = new ChunkDecoder(path, cx, cz, data);
+  // finished (and rendered) Chunks are reported without a detour through
+  // the GUI thread, receivers of chunkLoaded have to be thread safe
+  connect(decoder, SIGNAL(loaded(int, int)),
+          this,    SIGNAL(chunkLoaded(int, int)), Qt::DirectConnection);
+  WorkerPools::Instance().start(WorkerPools::stageCPU, decoder, priority);
+}
+
+void ChunkCache::setOverlayDemand(int parts) {
+  int added = parts & ~overlayDemand.fetchAndStoreOrdered(parts);
+  if (added == 0)
+    return;
+
+  // Chunks in the cache were loaded without these parts
+  QList<ChunkID> ids;
+  QList<QSharedPointer<Chunk>> chunks;
+  mutex.lock();
+  for (auto &id : cache.keys()) {
+    QSharedPointer<Chunk> chunk(*cache.object(id));
+    if (chunk->loaded && (chunk->missingParts() & added)) {
+      ids.append(id);
+      chunks.append(chunk);
+    }
+  }
+  mutex.unlock();
+  for (int i = 0; i < ids.size(); i++) {
+    ChunkPartDecoder *decoder =
+        new ChunkPartDecoder(chunks[i], ids[i].getX(), ids[i].getZ());
+    connect(decoder, SIGNAL(loaded(int, int)),
+            this,    SIGNAL(chunkPartsLoaded(int, int)), Qt::DirectConnection);
+    WorkerPools::Instance().start(WorkerPools::stageCPU, decoder);
+  }
+}
+
+int ChunkCache::getOverlayDemand() const {
+  return overlayDemand.load();
+}
+
+void ChunkCache::setRenderSettings(int depth, int flags) {
+  renderSettings.store((depth & 0xffff) | (flags << 16));
+}
+
+bool ChunkCache::getRenderSettings(int *depth, int *flags) const {
+  int settings = renderSettings.load();
+  if (settings == -1)
+    return false;
+  *depth = settings & 0xffff;
+  *flags = settings >> 16;
+  return true;
 }
 
 void ChunkCache::gotChunk(int cx, int cz) {
@@ -124,6 +261,130 @@ void ChunkCache::routeStructure(QSharedPointer<GeneratedStructure> structure) {
   emit structureFound(structure);
 }
 
+bool ChunkCache::isKnownEmpty(int cx, int cz) {
+  ChunkID region(cx >> 5, cz >> 5);
+  bool empty = false;
+  mutex.lock();
+  if (missingRegions.contains(region)) {
+    empty = true;
+  } else {
+    auto it = regionChunks.constFind(region);
+    if (it != regionChunks.constEnd())
+      empty = !it->testBit((cx & 31) + (cz & 31) * 32);
+  }
+  mutex.unlock();
+  return empty;
+}
+
+void ChunkCache::setRegionMissing(const QString &path, int rx, int rz) {
+  mutex.lock();
+  if (path == this->path)
+    missingRegions.insert(ChunkID(rx, rz));
+  mutex.unlock();
+}
+
+void ChunkCache::setRegionHeader(const QString &path, int rx, int rz,
+                                 const uchar *header,
+                                 const QString &filename) {
+  ChunkID region(rx, rz);
+  mutex.lock();
+  // a loader still running for the previous world must not fill this one
+  bool known = (path != this->path) || regionChunks.contains(region);
+  if (!known) {
+    // a Chunk exists when its location entry in the header is not zero
+    QBitArray available(32 * 32);
+    for (int i = 0; i < 32 * 32; i++)
+      available.setBit(i, (header[4*i] | header[4*i+1] | header[4*i+2]) != 0);
+    regionChunks.insert(region, available);
+  }
+  mutex.unlock();
+
+  // the watcher lives in the GUI thread
+  if (!known)
+    QMetaObject::invokeMethod(this, "watchRegionFile", Qt::QueuedConnection,
+                              Q_ARG(QString, filename));
+}
+
+void ChunkCache::removeChunk(const QString &path, int cx, int cz) {
+  ChunkID id(cx, cz);
+  mutex.lock();
+  if (path == this->path) {
+    cache.remove(id);
+    rawCache.remove(id);
+  }
+  mutex.unlock();
+}
+
+bool ChunkCache::fetchRaw(int cx, int cz, QByteArray *data) {
+  ChunkID id(cx, cz);
+  mutex.lock();
+  QByteArray * p_data(rawCache[id]);
+  if (p_data != NULL)
+    *data = *p_data;  // implicitly shared, no copy
+  mutex.unlock();
+  PerfCounters::Instance().add(p_data != NULL ? PerfCounters::cntRawHit
+                                              : PerfCounters::cntRawMiss);
+  return (p_data != NULL);
+}
+
+bool ChunkCache::readRaw(int cx, int cz, QByteArray *data) {
+  if (fetchRaw(cx, cz, data))
+    return true;
+  QString path = getPath();
+  if (!ChunkLoader::readAgain(path, cx, cz, data))
+    return false;
+  storeRaw(path, cx, cz, *data);
+  return true;
+}
+
+void ChunkCache::storeRaw(const QString &path, int cx, int cz,
+                          const QByteArray &data) {
+  ChunkID id(cx, cz);
+  int cost = qMax(1, data.size() / 1024);
+  mutex.lock();
+  // checked under the lock, clear() might have happened since chunkRead()
+  if (path == this->path)
+    rawCache.insert(id, new QByteArray(data), cost);
+  mutex.unlock();
+}
+
+void ChunkCache::watchRegionFile(QString filename) {
+  if (!watcher.files().contains(filename))
+    watcher.addPath(filename);
+}
+
+void ChunkCache::regionFolderChanged(const QString &folder) {
+  // Region files were added or removed
+  mutex.lock();
+  missingRegions.clear();
+  mutex.unlock();
+
+  // the region folder might have been created just now
+  QString regionFolder = path + "/region";
+  if (folder == path && QDir(regionFolder).exists() &&
+      !watcher.directories().contains(regionFolder))
+    watcher.addPath(regionFolder);
+}
+
+void ChunkCache::regionFileChanged(const QString &filename) {
+  // file name is "r.<rx>.<rz>.mca"
+  QStringList parts = QFileInfo(filename).fileName().split('.');
+  if (parts.length() != 4)
+    return;
+  ChunkID region(parts[1].toInt(), parts[2].toInt());
+  mutex.lock();
+  regionChunks.remove(region);
+  // compressed data of this Region is outdated
+  for (auto &id : rawCache.keys())
+    if ((id.getX() >> 5) == region.getX() && (id.getZ() >> 5) == region.getZ())
+      rawCache.remove(id);
+  mutex.unlock();
+  RenderCache::Instance().removeRegion(region.getX(), region.getZ());
+  reader->regionChanged(filename);
+  // header is evaluated again during next load, which also renews the watch
+  watcher.removePath(filename);
+}
+
 void ChunkCache::adaptCacheToWindow(int wx, int wy) {
   int chunks = ((wx + 15) >> 4) * ((wy + 15) >> 4);  // number of chunks visible
   chunks *= 1.10;  // add 10%
@@ -4,14 +4,20 @@
 
 #include <QObject>
 #include <QCache>
+#include <QBitArray>
+#include <QFileSystemWatcher>
 #include "./chunk.h"
+class RegionReader;
 
 // ChunkID is the key used to identify entries in the Cache
 // Chunks are identified by their coordinates (CX,CZ) but a single key is needed to access a map like structure
+// (the same key is used for Regions with their coordinates (RX,RZ))
 class ChunkID {
  public:
   ChunkID(int cx, int cz);
   bool operator==(const ChunkID &) const;
+  int getX() const { return cx; }
+  int getZ() const { return cz; }
   friend uint qHash(const ChunkID &);
  protected:
   int cx, cz;
@@ -37,12 +43,50 @@ class ChunkCache : public QObject {
   QString getPath() const;
   QSharedPointer<Chunk> fetch(int cx, int cz);         // fetch Chunk and load when not found
   QSharedPointer<Chunk> fetchCached(int cx, int cz);   // fetch Chunk only if cached
+  void prefetch(int cx, int cz);                       // load Chunk with low priority
   int getCost() const;
   int getMaxCost() const;
 
+  // negative cache: remember Regions and Chunks that do not exist on disk
+  // (results of loaders for another path than the current are ignored)
+  bool isKnownEmpty(int cx, int cz);
+  void setRegionMissing(const QString &path, int rx, int rz);
+  void setRegionHeader(const QString &path, int rx, int rz,
+                       const uchar *header, const QString &filename);
+  void removeChunk(const QString &path, int cx, int cz);
+
+  // second tier: compressed Chunk data as stored in the Region file
+  bool fetchRaw(int cx, int cz, QByteArray *data);
+  void storeRaw(const QString &path, int cx, int cz, const QByteArray &data);
+  // like fetchRaw(), but reads the Region file again on a miss
+  // (blocking, not to be used on the GUI thread)
+  bool readRaw(int cx, int cz, QByteArray *data);
+  // second stage of loading: decode compressed data in the CPU pool
+  void startDecoder(const QString &path, int cx, int cz,
+                    const QByteArray &data, int priority);
+  // called by the RegionReader (from any thread), reads that finish after
+  // a switch to another path are dropped
+  void chunkRead(const QString &path, int cx, int cz, const QByteArray &data,
+                 int priority);
+  void chunkUnavailable(int cx, int cz);
+
+  // parts of Chunks that are needed by the visible overlays
+  // (cached Chunks are parsed again in the CPU pool for newly needed parts)
+  void setOverlayDemand(int parts);
+  int getOverlayDemand() const;
+
+  // view settings used to render Chunks right after decoding them
+  void setRenderSettings(int depth, int flags);
+  bool getRenderSettings(int *depth, int *flags) const;
+
+ private:
+  void startLoader(int cx, int cz, int priority);
+
  signals:
   void chunkLoaded(int cx, int cz);
+  void chunkPartsLoaded(int cx, int cz);
   void structureFound(QSharedPointer<GeneratedStructure> structure);
+  void structureTypeFound(QString type, QColor color);
 
  public slots:
   void adaptCacheToWindow(int wx, int wy);
@@ -50,13 +94,23 @@ class ChunkCache : public QObject {
  private slots:
   void gotChunk(int cx, int cz);
   void routeStructure(QSharedPointer<GeneratedStructure> structure);
+  void watchRegionFile(QString filename);
+  void regionFolderChanged(const QString &folder);
+  void regionFileChanged(const QString &filename);
 
  private:
   QString path;                                   // path to folder with region files
   QCache<ChunkID, QSharedPointer<Chunk>> cache;   // real Cache
-  QMutex mutex;                                   // Mutex for accessing the Cache
+  QCache<ChunkID, QByteArray> rawCache;           // compressed Chunks, cost in KiB
+  static const int RAW_CACHE_MB = 256;            // budget for compressed Chunks
+  mutable QMutex mutex;                           // Mutex for accessing the Cache and path
   int maxcache;                                   // number of Chunks that fit into Cache
-  QThreadPool loaderThreadPool;                   // extra thread pool for loading
+  QSet<ChunkID> missingRegions;                   // Regions without a file on disk
+  QHash<ChunkID, QBitArray> regionChunks;         // existing Chunks per Region (from header)
+  QFileSystemWatcher watcher;                     // invalidates the negative cache
+  QAtomicInt overlayDemand;                       // Chunk parts to parse during load
+  QAtomicInt renderSettings;                      // depth | flags << 16, -1 = none
+  RegionReader *reader;                           // first stage of loading
 };
 
 #endif  // CHUNKCACHE_H_
@@ -3,58 +3,193 @@
 #include "./chunkloader.h"
 #include "./chunkcache.h"
 #include "./chunk.h"
+#include "./chunkrenderer.h"
+#include "./nbt.h"
+#include "./perfcounters.h"
+#include "./regionreader.h"
+#include "./tracerecorder.h"
+#include "./workerpools.h"
 
 
-ChunkLoader::ChunkLoader(QString path, int cx, int cz)
+ChunkLoader::ChunkLoader(QString path, int cx, int cz, int priority)
   : path(path)
   , cx(cx), cz(cz)
+  , priority(priority)
   , cache(ChunkCache::Instance())
-{}
+{
+  queued.start();
+}
 
 ChunkLoader::~ChunkLoader()
 {}
 
+// first stage: read the compressed data (I/O bound)
 void ChunkLoader::run() {
+  WorkerPools::Instance().reportWait(WorkerPools::stageIO,
+                                     queued.nsecsElapsed());
+  QByteArray data;
+  {
+    PerfScope scope(PerfCounters::stgRead);
+    TraceScope trace("read", cx, cz);
+    if (!readChunk(&data)) {
+      emit loaded(cx, cz);
+      return;
+    }
+  }
+  // decoding continues in the CPU pool
+  cache.chunkRead(path, cx, cz, data, priority);
+}
+
+// read the compressed Chunk data from its Region file
+// (plain reads instead of mapping, page faults would block the thread
+// at unpredictable places)
+bool ChunkLoader::readChunk(QByteArray *data) {
   // get coordinates of Region file
   int rx = cx >> 5;
   int rz = cz >> 5;
 
-  QFile f(path + "/region/r." + QString::number(rx) + "." +
-          QString::number(rz) + ".mca");
-  if (!f.open(QIODevice::ReadOnly)) {  // no chunks in this region
-    emit loaded(cx, cz);
-    return;
+  QFile f(RegionReader::regionFile(path, cx, cz));
+  if (!f.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    // no chunks in this region
+    cache.setRegionMissing(path, rx, rz);
+    cache.removeChunk(path, cx, cz);
+    return false;
+  }
+  QByteArray header = f.read(RegionReader::SECTOR_SIZE);
+  if (header.size() < RegionReader::SECTOR_SIZE) {  // incomplete region file
+    f.close();
+    return false;
   }
-  // map header into memory
-  uchar *header = f.map(0, 4096);
-  int offset = 4 * ((cx & 31) + (cz & 31) * 32);
-  int coffset = (header[offset] << 16) | (header[offset + 1] << 8) |
-      header[offset + 2];
-  int numSectors = header[offset+3];
-  f.unmap(header);
+  const uchar *raw = reinterpret_cast<const uchar*>(header.constData());
+  cache.setRegionHeader(path, rx, rz, raw, f.fileName());
+  int numSectors;
+  int coffset = RegionReader::sectorOffset(raw, cx, cz, &numSectors);
 
   if (coffset == 0) {  // no chunk
     f.close();
-    emit loaded(cx, cz);
-    return;
+    cache.removeChunk(path, cx, cz);
+    return false;
   }
 
-  uchar *raw = f.map(coffset * 4096, numSectors * 4096);
-  if (raw == NULL) {
-    f.close();
+  bool ok = readPayload(&f, coffset, numSectors, data);
+  f.close();
+  return ok;
+}
+
+// read the compressed Chunk data again, e.g. after it was dropped from
+// the ChunkCache (without reporting anything about the Region)
+bool ChunkLoader::readAgain(const QString &path, int cx, int cz,
+                            QByteArray *data) {
+  QFile f(RegionReader::regionFile(path, cx, cz));
+  if (!f.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+    return false;
+  QByteArray header = f.read(RegionReader::SECTOR_SIZE);
+  int numSectors;
+  int coffset = 0;
+  if (header.size() == RegionReader::SECTOR_SIZE)
+    coffset = RegionReader::sectorOffset(
+        reinterpret_cast<const uchar*>(header.constData()), cx, cz,
+        &numSectors);
+  bool ok = (coffset != 0) && readPayload(&f, coffset, numSectors, data);
+  f.close();
+  return ok;
+}
+
+// copy the sectors of one Chunk, trimmed to the stored length
+bool ChunkLoader::readPayload(QFile *f, int coffset, int numSectors,
+                              QByteArray *data) {
+  if (!f->seek(static_cast<qint64>(coffset) * RegionReader::SECTOR_SIZE))
+    return false;
+  *data = f->read(numSectors * RegionReader::SECTOR_SIZE);
+  return RegionReader::trimPayload(data);
+}
+
+ChunkDecoder::ChunkDecoder(QString path, int cx, int cz,
+                           const QByteArray &data)
+  : path(path)
+  , cx(cx), cz(cz)
+  , data(data)
+  , cache(ChunkCache::Instance())
+{
+  queued.start();
+}
+
+ChunkDecoder::~ChunkDecoder()
+{}
+
+// second stage: parse the compressed data and render it (CPU bound)
+void ChunkDecoder::run() {
+  WorkerPools::Instance().reportWait(WorkerPools::stageCPU,
+                                     queued.nsecsElapsed());
+
+  // get existing Chunk entry from Cache
+  // (after a switch to another world, the entry is not ours any more)
+  QSharedPointer<Chunk> chunk;
+  if (path == cache.getPath())
+    chunk = cache.fetchCached(cx, cz);
+  if (!chunk) {
     emit loaded(cx, cz);
     return;
   }
-  // get existing Chunk entry from Cache
-  QSharedPointer<Chunk> chunk(cache.fetchCached(cx, cz));
+
+  // it is rendered below with the current view settings,
+  // the view must not start another job as soon as it is loaded
+  int depth, flags;
+  bool render = cache.getRenderSettings(&depth, &flags);
+  if (render)
+    chunk->rendering.store(1);
+
   // parse Chunk data
   // Chunk will be flagged "loaded" in a thread save way
-  if (chunk) {
-    NBT nbt(raw);
-    chunk->load(nbt);
+  {
+    PerfScope scope(PerfCounters::stgDecode);
+    TraceScope trace("decode", cx, cz);
+    int parts = cache.getOverlayDemand();
+    NBT nbt(reinterpret_cast<const uchar*>(data.constData()));
+    chunk->load(nbt, parts);
+    // overlays might have changed meanwhile
+    chunk->loadMissing(cache.getOverlayDemand(), data);
   }
-  f.unmap(raw);
-  f.close();
 
+  // render on this thread, the view gets a finished tile
+  bool eastChanged = false;
+  if (render) {
+    PerfScope scope(PerfCounters::stgRender);
+    TraceScope trace("render", cx, cz);
+    ChunkRenderer renderer(cx, cz, depth, flags);
+    eastChanged = renderer.renderWithNeighbour(chunk);
+    chunk->rendering.storeRelease(0);
+  }
+
+  emit loaded(cx, cz);
+  if (eastChanged)
+    emit loaded(cx + 1, cz);
+}
+
+ChunkPartDecoder::ChunkPartDecoder(QSharedPointer<Chunk> chunk,
+                                   int cx, int cz)
+  : chunk(chunk)
+  , cx(cx), cz(cz)
+  , cache(ChunkCache::Instance())
+{
+  queued.start();
+}
+
+ChunkPartDecoder::~ChunkPartDecoder()
+{}
+
+void ChunkPartDecoder::run() {
+  WorkerPools::Instance().reportWait(WorkerPools::stageCPU,
+                                     queued.nsecsElapsed());
+  {
+    PerfScope scope(PerfCounters::stgDecode);
+    TraceScope trace("decode parts", cx, cz);
+    // the compressed data is not kept with the Chunk
+    // (it is read again when it was dropped from the ChunkCache)
+    int parts = cache.getOverlayDemand() & chunk->missingParts();
+    QByteArray data;
+    if (parts && cache.readRaw(cx, cz, &data))
+      chunk->loadMissing(parts, data);
+  }
   emit loaded(cx, cz);
 }
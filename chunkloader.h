@@ -4,14 +4,22 @@
 
 #include <QObject>
 #include <QRunnable>
+#include <QSharedPointer>
+#include <QElapsedTimer>
 #include "chunkcache.h"
 
+class QFile;
+
+// reads the compressed data of a Chunk and passes it to a ChunkDecoder
 class ChunkLoader : public QObject, public QRunnable {
   Q_OBJECT
 
  public:
-  ChunkLoader(QString path, int cx, int cz);
+  ChunkLoader(QString path, int cx, int cz, int priority);
   ~ChunkLoader();
+  // blocking read of the compressed data of a Chunk
+  static bool readAgain(const QString &path, int cx, int cz,
+                        QByteArray *data);
 
  signals:
   void loaded(int cx, int cz);
@@ -20,8 +28,57 @@ class ChunkLoader : public QObject, public QRunnable {
   void run();
 
  private:
+  bool readChunk(QByteArray *data);
+  static bool readPayload(QFile *f, int coffset, int numSectors,
+                          QByteArray *data);
+
   QString path;
   int     cx, cz;
+  int     priority;
+  QElapsedTimer queued;  // time spent waiting for a thread
+  ChunkCache &cache;
+};
+
+// parses the compressed data of a Chunk into the Chunk in the ChunkCache
+class ChunkDecoder : public QObject, public QRunnable {
+  Q_OBJECT
+
+ public:
+  ChunkDecoder(QString path, int cx, int cz, const QByteArray &data);
+  ~ChunkDecoder();
+
+ signals:
+  void loaded(int cx, int cz);
+
+ protected:
+  void run();
+
+ private:
+  QString    path;
+  int        cx, cz;
+  QByteArray data;
+  QElapsedTimer queued;  // time spent waiting for a thread
+  ChunkCache &cache;
+};
+
+// parses the parts of a loaded Chunk that were skipped while decoding it
+class ChunkPartDecoder : public QObject, public QRunnable {
+  Q_OBJECT
+
+ public:
+  ChunkPartDecoder(QSharedPointer<Chunk> chunk, int cx, int cz);
+  ~ChunkPartDecoder();
+
+ signals:
+  void loaded(int cx, int cz);
+
+ protected:
+  void run();
+
+ private:
+  QSharedPointer<Chunk> chunk;
+  int        cx, cz;
+  QElapsedTimer queued;  // time spent waiting for a thread
   ChunkCache &cache;
 };
 
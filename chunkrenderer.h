@@ -4,6 +4,7 @@
 
 #include <QObject>
 #include <QRunnable>
+#include <QElapsedTimer>
 #include "chunkcache.h"
 
 class ChunkRenderer : public QObject, public QRunnable {
@@ -11,21 +12,40 @@ class ChunkRenderer : public QObject, public QRunnable {
 
  public:
   ChunkRenderer(int cx, int cz, int y, int flags);
+  // job rendering the given Chunk, which has to be flagged as rendering
+  // (the flag is cleared when the job is finished)
+  ChunkRenderer(QSharedPointer<Chunk> chunk, int y, int flags);
   ~ChunkRenderer() {}
 
  protected:
   void run();
 
- public:  // public to allow usage from WorldSave
+ public:  // public to allow usage from WorldSave and ChunkDecoder
   void renderChunk(QSharedPointer<Chunk> chunk);
+  // returns true when the eastern column changed, so the eastern
+  // neighbour might have to shade its western edge again
+  bool renderWithNeighbour(QSharedPointer<Chunk> chunk);
+  // render privately loaded Chunks (export): the western neighbour is
+  // given instead of looked up in the ChunkCache, Chunks are rendered
+  // completely and results are not cached
+  void setExport(QSharedPointer<Chunk> west);
+
+ private:
+  void renderColumn(Chunk *chunk, int offset, int lasty);
+  bool getWestDepth(const Chunk &chunk, int *westDepth);
 
  signals:
   void rendered(int cx, int cz);
 
  private:
+  QSharedPointer<Chunk> chunk;  // of a job
   int cx, cz;
   int depth;
   int flags;
+  int generation;  // of the block definitions
+  bool exporting;
+  QSharedPointer<Chunk> exportWest;
+  QElapsedTimer queued;  // time spent waiting for a thread
   ChunkCache &cache;
 };
 
@@ -33,7 +53,10 @@ class CaveShade {
  public:
   // singleton: access to global usable instance
   static float getShade(int index);
+  // sum of shades of all blocks set in a window of CAVE_DEPTH blocks
+  static float getShadeSum(quint16 window);
  private:
+  static CaveShade &Instance();
   // singleton: prevent access to constructor and copyconstructor
   CaveShade();
   ~CaveShade() {}
@@ -43,6 +66,9 @@ class CaveShade {
  public:
   static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
   float caveshade[CAVE_DEPTH];
+ private:
+  float shadeLow[256];   // lookup for the lower 8 bits of a window
+  float shadeHigh[256];  // lookup for the upper 8 bits of a window
 };
 
 #endif // CHUNKRENDERER_H
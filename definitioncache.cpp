@@ -0,0 +1,194 @@
+/** Copyright (c) 2026, Minutor contributors */
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <cstring>
+
+#include "./definitioncache.h"
+
+// increase whenever the layout of one of the Cached* records changes
+static const quint32 CACHE_VERSION = 1;
+static const char CACHE_MAGIC[8] = {'M', 'N', 'T', 'R', 'D', 'E', 'F', 'S'};
+
+struct CachedHeader {
+  char    magic[8];
+  quint32 version;
+  char    key[20];  // SHA-1 of definition files
+  CachedTable definitions;
+  CachedTable palette;
+  CachedTable strings;  // count is in bytes
+};
+
+// all tables start 8 byte aligned, so records are usable from the mapping
+static quint32 align(quint32 offset) {
+  return (offset + 7) & ~7u;
+}
+static const quint32 TABLES_START = align(sizeof(CachedHeader));
+
+
+DefinitionCache::DefinitionCache()
+  : data(NULL)
+  , size(0) {
+  palette.offset = 0;
+  palette.count = 0;
+}
+
+DefinitionCache::~DefinitionCache() {
+  close();
+}
+
+QByteArray DefinitionCache::computeKey(const QStringList &paths) {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  // cached name hashes are only valid for the Qt version that created them,
+  // and the parsing of definitions might change with every release
+  hash.addData(QByteArray(qVersion()));
+  hash.addData(QCoreApplication::applicationVersion().toUtf8());
+  for (const QString &path : paths) {
+    hash.addData(path.toUtf8());
+    QFile f(path);
+    if (f.open(QIODevice::ReadOnly))
+      hash.addData(&f);
+  }
+  return hash.result();
+}
+
+bool DefinitionCache::open(const QString &filename, const QByteArray &key) {
+  close();
+  file.setFileName(filename);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  if (file.size() < TABLES_START || file.size() > 0x7fffffff) {
+    close();
+    return false;
+  }
+  size = file.size();
+  data = file.map(0, size);
+  if (data == NULL) {
+    close();
+    return false;
+  }
+
+  // check everything once, so that readers can use the tables blindly
+  const CachedHeader *header = reinterpret_cast<const CachedHeader *>(data);
+  bool ok =
+      memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+      header->version == CACHE_VERSION &&
+      key.size() == sizeof(header->key) &&
+      memcmp(header->key, key.constData(), sizeof(header->key)) == 0 &&
+      isValid(header->definitions, sizeof(CachedDefinition)) &&
+      isValid(header->palette, sizeof(CachedPaletteEntry)) &&
+      isValid(header->strings, 1);
+  for (quint32 i = 0; ok && i < header->definitions.count; i++) {
+    const CachedDefinition &def =
+        getRecords<CachedDefinition>(header->definitions)[i];
+    ok = isValid(def.blocks, sizeof(CachedBlock)) &&
+         isValid(def.biomes, sizeof(CachedBiome)) &&
+         isValid(def.dimensions, sizeof(CachedDimension)) &&
+         isValid(def.categories, sizeof(CachedCategory)) &&
+         isValid(def.entities, sizeof(CachedEntity));
+  }
+  if (!ok)
+    close();
+  return ok;
+}
+
+void DefinitionCache::close() {
+  if (data != NULL)
+    file.unmap(const_cast<uchar *>(data));
+  file.close();
+  data = NULL;
+  size = 0;
+}
+
+bool DefinitionCache::isValid(const CachedTable &table,
+                              quint32 recordSize) const {
+  if (table.offset % 8 != 0 || table.offset > size)
+    return false;
+  return quint64(table.count) * recordSize <= size - table.offset;
+}
+
+int DefinitionCache::numDefinitions() const {
+  if (data == NULL)
+    return 0;
+  return reinterpret_cast<const CachedHeader *>(data)->definitions.count;
+}
+
+const CachedDefinition &DefinitionCache::getDefinition(int index) const {
+  const CachedHeader *header = reinterpret_cast<const CachedHeader *>(data);
+  return getRecords<CachedDefinition>(header->definitions)[index];
+}
+
+const CachedTable &DefinitionCache::getPalette() const {
+  if (data == NULL)
+    return palette;  // empty
+  return reinterpret_cast<const CachedHeader *>(data)->palette;
+}
+
+QString DefinitionCache::getString(const CachedString &string) const {
+  const CachedTable &pool =
+      reinterpret_cast<const CachedHeader *>(data)->strings;
+  if (quint64(string.offset) + string.length > pool.count)
+    return QString();
+  return QString::fromUtf8(
+      reinterpret_cast<const char *>(data + pool.offset + string.offset),
+      string.length);
+}
+
+CachedString DefinitionCache::addString(const QString &string) {
+  // most names are shared between packs and variants
+  auto it = stringIndex.constFind(string);
+  if (it != stringIndex.constEnd())
+    return it.value();
+  QByteArray utf8 = string.toUtf8();
+  CachedString cached;
+  memset(&cached, 0, sizeof(cached));
+  cached.offset = strings.size();
+  cached.length = utf8.size();
+  strings.append(utf8);
+  stringIndex.insert(string, cached);
+  return cached;
+}
+
+CachedTable DefinitionCache::addRecords(const void *records, int recordSize,
+                                        int count) {
+  tables.append(QByteArray(align(tables.size()) - tables.size(), '\0'));
+  CachedTable table;
+  memset(&table, 0, sizeof(table));
+  table.offset = TABLES_START + tables.size();
+  table.count = count;
+  tables.append(reinterpret_cast<const char *>(records), recordSize * count);
+  return table;
+}
+
+void DefinitionCache::addDefinition(const CachedDefinition &definition) {
+  definitions.append(definition);
+}
+
+void DefinitionCache::setPalette(const CachedTable &table) {
+  palette = table;
+}
+
+bool DefinitionCache::save(const QString &filename, const QByteArray &key) {
+  CachedHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  memcpy(header.key, key.constData(),
+         qMin(sizeof(header.key), size_t(key.size())));
+  header.definitions = addRecords(definitions);
+  header.palette = palette;
+  tables.append(QByteArray(align(tables.size()) - tables.size(), '\0'));
+  header.strings.offset = TABLES_START + tables.size();
+  header.strings.count = strings.size();
+
+  // never leave a half written database behind
+  QSaveFile f(filename);
+  if (!f.open(QIODevice::WriteOnly))
+    return false;
+  f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  f.write(QByteArray(TABLES_START - sizeof(header), '\0'));
+  f.write(tables);
+  f.write(strings);
+  return f.commit();
+}
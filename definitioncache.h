@@ -0,0 +1,144 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef DEFINITIONCACHE_H_
+#define DEFINITIONCACHE_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Compiled definition database
+//
+// The result of parsing all definition packs is stored as flat tables of
+// plain records, strings are kept in one shared UTF-8 pool. At startup the
+// whole file is mapped and the Identifiers are filled directly from the
+// records, no JSON is touched at all. The database is only valid for the
+// exact list of definition files (including their content) it was
+// compiled from.
+
+struct CachedString {
+  quint32 offset;  // into string pool
+  quint32 length;  // in bytes
+};
+
+struct CachedTable {
+  quint32 offset;  // from start of file
+  quint32 count;   // number of records
+};
+
+struct CachedBlock {
+  CachedString name;
+  CachedString blockstate;
+  quint32 hid;
+  quint32 colors[16];  // QRgb for every light level
+  double  alpha;
+  quint8  variants;
+  quint8  transparent;
+  quint8  liquid;
+  quint8  rendernormal;
+  quint8  providepower;
+  quint8  spawninside;
+  quint8  grass;
+  quint8  foliage;
+};
+
+struct CachedBiome {
+  qint32  id;
+  CachedString name;
+  quint32 colors[16];  // QRgb for every light level
+  quint32 watermodifier;
+  quint32 enabledwatermodifier;
+  double  alpha;
+  double  temperature;
+  double  humidity;
+};
+
+struct CachedDimension {
+  CachedString name;
+  CachedString path;
+  qint32  scale;
+  quint32 regex;
+};
+
+struct CachedCategory {
+  CachedString name;
+  quint32 color;
+};
+
+struct CachedEntity {
+  CachedString id;
+  CachedString name;
+  CachedString category;
+  quint32 brushColor;
+  quint32 penColor;
+};
+
+struct CachedPaletteEntry {
+  quint32 bid;
+  quint32 hid;
+  CachedString name;
+};
+
+struct CachedDefinition {
+  CachedString name;
+  CachedString version;
+  CachedString path;
+  CachedString update;
+  quint32 type;  // Definition::type
+  CachedTable blocks;
+  CachedTable biomes;
+  CachedTable dimensions;
+  CachedTable categories;
+  CachedTable entities;
+};
+
+class DefinitionCache {
+ public:
+  DefinitionCache();
+  ~DefinitionCache();
+
+  // key over the ordered list of definition files and their content
+  static QByteArray computeKey(const QStringList &paths);
+
+  // map an existing database, fails when it does not match the key
+  bool open(const QString &filename, const QByteArray &key);
+  void close();
+  int numDefinitions() const;
+  const CachedDefinition &getDefinition(int index) const;
+  const CachedTable &getPalette() const;
+  QString getString(const CachedString &string) const;
+  template <class T>
+  const T *getRecords(const CachedTable &table) const {
+    return reinterpret_cast<const T *>(data + table.offset);
+  }
+
+  // collect compiled tables and write them as a new database
+  CachedString addString(const QString &string);
+  template <class T>
+  CachedTable addRecords(const QVector<T> &records) {
+    return addRecords(records.constData(), sizeof(T), records.size());
+  }
+  void addDefinition(const CachedDefinition &definition);
+  void setPalette(const CachedTable &palette);
+  bool save(const QString &filename, const QByteArray &key);
+
+ private:
+  CachedTable addRecords(const void *records, int size, int count);
+  bool isValid(const CachedTable &table, quint32 size) const;
+
+  // reading
+  QFile file;
+  const uchar *data;
+  quint32 size;
+
+  // writing
+  QByteArray tables;
+  QByteArray strings;
+  QHash<QString, CachedString> stringIndex;
+  QVector<CachedDefinition> definitions;
+  CachedTable palette;
+};
+
+#endif  // DEFINITIONCACHE_H_
@@ -8,9 +8,13 @@
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QPushButton>
 #include <QStandardPaths>
+#include <QThreadPool>
 #include <QtWidgets/QFileDialog>
 #include <algorithm>
+#include <memory>
+#include <vector>
 #include "./definitionmanager.h"
+#include "./definitioncache.h"
 #include "./biomeidentifier.h"
 #include "./blockidentifier.h"
 #include "./dimensionidentifier.h"
@@ -77,8 +81,20 @@ DefinitionManager::DefinitionManager(QWidget *parent) :
   // we load the definitions in backwards order for priority
   QSettings settings;
   sorted = settings.value("packs").toList();
+  QStringList paths;
   for (int i = sorted.length() - 1; i >= 0; i--)
-    loadDefinition(sorted[i].toString());
+    paths.append(sorted[i].toString());
+
+  // use the compiled database as long as no definition file changed
+  QString cachedir = QStandardPaths::writableLocation(
+      QStandardPaths::CacheLocation);
+  QDir().mkpath(cachedir);
+  QString cachefile = cachedir + "/definitions.db";
+  QByteArray key = DefinitionCache::computeKey(paths);
+  if (!loadCompiled(cachefile, key)) {
+    loadDefinitions(paths);
+    saveCompiled(cachefile, key, paths);
+  }
 
   // hook up table selection signal
   connect(table,
@@ -403,19 +419,87 @@ QSize DefinitionManager::sizeHint() const {
   return QSize(400, 300);
 }
 
-void DefinitionManager::loadDefinition(QString path) {
+// JSON of one definition file, parsed without touching any Identifier
+struct ParsedDefinition {
+  bool valid;
+  std::unique_ptr<JSONData> info;  // single json or pack_info.json
+  std::vector<std::unique_ptr<JSONData>> data;  // pack content, in order
+};
+
+static void parseDefinition(const QString &path, ParsedDefinition *parsed) {
+  parsed->valid = false;
   // determine if we're loading a single json or a pack
   if (path.endsWith(".json", Qt::CaseInsensitive)) {
-    std::unique_ptr<JSONData> def;
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly)) return;
     try {
-      def = JSON::parse(f.readAll());
+      parsed->info = JSON::parse(f.readAll());
       f.close();
     } catch (JSONParseException e) {
       f.close();
       return;
     }
+  } else {
+    ZipReader zip(path);
+    if (!zip.open())
+      return;
+    try {
+      parsed->info = JSON::parse(zip.get("pack_info.json"));
+    } catch (JSONParseException e) {
+      zip.close();
+      return;
+    }
+    JSONData *files = parsed->info->at("data");
+    for (int i = 0; i < files->length(); i++) {
+      try {
+        parsed->data.push_back(
+            JSON::parse(zip.get(files->at(i)->asString())));
+      } catch (JSONParseException e) {
+        continue;
+      }
+    }
+    zip.close();
+  }
+  parsed->valid = true;
+}
+
+class DefinitionParser : public QRunnable {
+ public:
+  DefinitionParser(const QString &path, ParsedDefinition *parsed)
+    : path(path), parsed(parsed) {}
+ protected:
+  void run() {
+    parseDefinition(path, parsed);
+  }
+ private:
+  QString path;
+  ParsedDefinition *parsed;
+};
+
+void DefinitionManager::loadDefinitions(const QStringList &paths) {
+  // parsing is independent per file and runs in parallel, adding to the
+  // Identifiers stays in order as later definitions override earlier ones
+  std::vector<ParsedDefinition> parsed(paths.length());
+  QThreadPool pool;
+  for (int i = 0; i < paths.length(); i++)
+    pool.start(new DefinitionParser(paths[i], &parsed[i]));
+  pool.waitForDone();
+  for (int i = 0; i < paths.length(); i++)
+    loadDefinition(paths[i], parsed[i]);
+}
+
+void DefinitionManager::loadDefinition(QString path) {
+  ParsedDefinition parsed;
+  parseDefinition(path, &parsed);
+  loadDefinition(path, parsed);
+}
+
+void DefinitionManager::loadDefinition(const QString &path,
+                                       const ParsedDefinition &parsed) {
+  if (!parsed.valid)
+    return;
+  if (path.endsWith(".json", Qt::CaseInsensitive)) {
+    JSONData *def = parsed.info.get();
     Definition d;
     d.name = def->at("name")->asString();
     d.version = def->at("version")->asString();
@@ -449,16 +533,7 @@ void DefinitionManager::loadDefinition(QString path) {
     }
     definitions.insert(path, d);
   } else {
-    ZipReader zip(path);
-    if (!zip.open())
-      return;
-    std::unique_ptr<JSONData> info;
-    try {
-      info = JSON::parse(zip.get("pack_info.json"));
-    } catch (JSONParseException e) {
-      zip.close();
-      return;
-    }
+    JSONData *info = parsed.info.get();
     Definition d;
     d.name = info->at("name")->asString();
     d.version = info->at("version")->asString();
@@ -472,13 +547,7 @@ void DefinitionManager::loadDefinition(QString path) {
     d.dimensionid = -1;
     d.entityid = -1;
     QString key = d.name+"pack";
-    for (int i = 0; i < info->at("data")->length(); i++) {
-      std::unique_ptr<JSONData> def;
-      try {
-        def = JSON::parse(zip.get(info->at("data")->at(i)->asString()));
-      } catch (JSONParseException e) {
-        continue;
-      }
+    for (const std::unique_ptr<JSONData> &def : parsed.data) {
       QString type = def->at("type")->asString();
       if (type == "block") {
 //        d.blockid = flatteningConverter->addDefinitions(
@@ -498,9 +567,111 @@ void DefinitionManager::loadDefinition(QString path) {
       }
     }
     definitions.insert(path, d);
-    zip.close();
   }
 }
+
+bool DefinitionManager::loadCompiled(const QString &filename,
+                                     const QByteArray &key) {
+  DefinitionCache cache;
+  if (!cache.open(filename, key))
+    return false;
+
+  for (int i = 0; i < cache.numDefinitions(); i++) {
+    const CachedDefinition &c = cache.getDefinition(i);
+    Definition d;
+    d.name = cache.getString(c.name);
+    d.version = cache.getString(c.version);
+    d.path = cache.getString(c.path);
+    d.update = cache.getString(c.update);
+    d.enabled = true;
+    d.id = 0;
+    d.blockid = -1;
+    d.biomeid = -1;
+    d.dimensionid = -1;
+    d.entityid = -1;
+    switch (c.type) {
+      case Definition::Block:
+        d.type = Definition::Block;
+        d.id = blockManager.addDefinitions(cache, c.blocks);
+        break;
+      case Definition::Biome:
+        d.type = Definition::Biome;
+        d.id = biomeManager.addDefinitions(cache, c.biomes);
+        break;
+      case Definition::Dimension:
+        d.type = Definition::Dimension;
+        d.id = dimensionManager.addDefinitions(cache, c.dimensions);
+        break;
+      case Definition::Entity:
+        d.type = Definition::Entity;
+        d.id = entityManager.addDefinitions(cache, c.categories, c.entities);
+        break;
+      case Definition::Pack:
+        // packs only own an id for the types they actually contain
+        d.type = Definition::Pack;
+        if (c.blocks.count > 0)
+          d.blockid = blockManager.addDefinitions(cache, c.blocks);
+        if (c.biomes.count > 0)
+          d.biomeid = biomeManager.addDefinitions(cache, c.biomes);
+        if (c.dimensions.count > 0)
+          d.dimensionid = dimensionManager.addDefinitions(cache,
+                                                          c.dimensions);
+        if (c.categories.count > 0 || c.entities.count > 0)
+          d.entityid = entityManager.addDefinitions(cache, c.categories,
+                                                    c.entities);
+        break;
+      default:  // converter data is part of the merged palette
+        d.type = Definition::Converter;
+        d.id = -1;
+        break;
+    }
+    definitions.insert(d.path, d);
+  }
+  flatteningConverter.addDefinitions(cache, cache.getPalette());
+  return true;
+}
+
+void DefinitionManager::saveCompiled(const QString &filename,
+                                     const QByteArray &key,
+                                     const QStringList &paths) {
+  DefinitionCache cache;
+  for (const QString &path : paths) {
+    if (!definitions.contains(path))
+      continue;  // failed to load, will fail again
+    const Definition &d = definitions[path];
+    CachedDefinition c;
+    memset(&c, 0, sizeof(c));
+    c.name = cache.addString(d.name);
+    c.version = cache.addString(d.version);
+    c.path = cache.addString(d.path);
+    c.update = cache.addString(d.update);
+    c.type = d.type;
+    int blockid = -1, biomeid = -1, dimensionid = -1, entityid = -1;
+    switch (d.type) {
+      case Definition::Block:     blockid = d.id;     break;
+      case Definition::Biome:     biomeid = d.id;     break;
+      case Definition::Dimension: dimensionid = d.id; break;
+      case Definition::Entity:    entityid = d.id;    break;
+      case Definition::Pack:
+        blockid = d.blockid;
+        biomeid = d.biomeid;
+        dimensionid = d.dimensionid;
+        entityid = d.entityid;
+        break;
+      default:
+        break;
+    }
+    c.blocks = blockManager.compileDefinitions(blockid, &cache);
+    c.biomes = biomeManager.compileDefinitions(biomeid, &cache);
+    c.dimensions = dimensionManager.compileDefinitions(dimensionid, &cache);
+    entityManager.compileDefinitions(entityid, &cache,
+                                     &c.categories, &c.entities);
+    cache.addDefinition(c);
+  }
+  cache.setPalette(flatteningConverter.compileDefinitions(&cache));
+  cache.save(filename, key);
+}
+
 void DefinitionManager::removeDefinition(QString path) {
   // find the definition and remove it from disk
   Definition &def = definitions[path];
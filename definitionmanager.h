@@ -8,6 +8,7 @@
 #include <QList>
 #include <QVariant>
 #include <QDateTime>
+#include <QStringList>
 
 class QTableWidget;
 class QTableWidgetItem;
@@ -20,6 +21,7 @@ class FlatteningConverter;
 class MapView;
 class JSONData;
 class DefinitionUpdater;
+struct ParsedDefinition;
 
 struct Definition {
   QString name;
@@ -67,8 +69,13 @@ class DefinitionManager : public QWidget {
   void installJson(QString path, bool overwrite = true, bool install = true);
   void installZip(QString path, bool overwrite = true, bool install = true);
   void checkAndRepair();
+  void loadDefinitions(const QStringList &paths);
   void loadDefinition(QString path);
+  void loadDefinition(const QString &path, const ParsedDefinition &parsed);
   void loadDefinition(JSONData *, int pack = -1);
+  bool loadCompiled(const QString &filename, const QByteArray &key);
+  void saveCompiled(const QString &filename, const QByteArray &key,
+                    const QStringList &paths);
   void removeDefinition(QString path);
   void refresh();
   QHash<QString, Definition> definitions;
@@ -3,6 +3,7 @@
 #include <QDirIterator>
 #include <QtWidgets/QMenu>
 #include "./dimensionidentifier.h"
+#include "./definitioncache.h"
 #include "./json.h"
 
 class DimensionDef {
@@ -83,6 +84,44 @@ int DimensionIdentifier::addDefinitions(JSONArray *defs, int pack) {
   return pack;
 }
 
+int DimensionIdentifier::addDefinitions(const DefinitionCache &cache,
+                                        const CachedTable &table, int pack) {
+  if (pack == -1) {
+    pack = packs.length();
+    packs.append(QList<DimensionDef*>());
+  }
+
+  const CachedDimension *records = cache.getRecords<CachedDimension>(table);
+  for (quint32 i = 0; i < table.count; i++) {
+    DimensionDef *dim = new DimensionDef();
+    dim->enabled = true;
+    dim->name = cache.getString(records[i].name);
+    dim->path = cache.getString(records[i].path);
+    dim->scale = records[i].scale;
+    dim->regex = records[i].regex;
+    definitions.append(dim);
+    packs[pack].append(dim);
+  }
+  return pack;
+}
+
+CachedTable DimensionIdentifier::compileDefinitions(
+    int pack, DefinitionCache *cache) const {
+  QVector<CachedDimension> records;
+  if (pack >= 0) {
+    for (const DimensionDef *dim : packs[pack]) {
+      CachedDimension d;
+      memset(&d, 0, sizeof(d));
+      d.name = cache->addString(dim->name);
+      d.path = cache->addString(dim->path);
+      d.scale = dim->scale;
+      d.regex = dim->regex;
+      records.append(d);
+    }
+  }
+  return cache->addRecords(records);
+}
+
 void DimensionIdentifier::removeDimensions(QMenu *menu) {
   for (int i = 0; i < items.count(); i++) {
     menu->removeAction(items[i]);
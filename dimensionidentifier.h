@@ -11,6 +11,8 @@ class QMenu;
 class QAction;
 class QActionGroup;
 class JSONArray;
+class DefinitionCache;
+struct CachedTable;
 
 class DimensionInfo {
  public:
@@ -31,6 +33,9 @@ class DimensionIdentifier : public QObject {
   static DimensionIdentifier &Instance();
 
   int addDefinitions(JSONArray *, int pack = -1);
+  int addDefinitions(const DefinitionCache &cache, const CachedTable &table,
+                     int pack = -1);
+  CachedTable compileDefinitions(int pack, DefinitionCache *cache) const;
   void enableDefinitions(int id);
   void disableDefinitions(int id);
   void getDimensions(QDir path, QMenu *menu, QObject *parent);
@@ -1,73 +1,172 @@
 /** Copyright 2014 EtlamGit */
 #include <QPainter>
+#include <QMutex>
+#include <QHash>
 #include "./entity.h"
 #include "./entityidentifier.h"
+#include "./chunkcache.h"
 #include "./nbt.h"
 
-QSharedPointer<OverlayItem> Entity::TryParse(const Tag* tag) {
+// table of all known Entity kinds
+// entries are never removed or changed (changed definitions add new kinds),
+// and a kind is only read through a record of a Chunk that is published
+// after internKind() returned, so getKind() needs no locking
+static const int MAX_KINDS = 65536;
+static Entity::Kind *kinds[MAX_KINDS];
+static int           numKinds = 0;
+static QHash<QString, quint16> kindIDs;
+static QMutex        kindMutex;
+
+quint16 Entity::internKind(const Kind &kind) {
+  QString key = kind.id + "/" + kind.type + "/" + kind.display + "/" +
+                kind.brushColor.name(QColor::HexArgb) + "/" +
+                kind.penColor.name(QColor::HexArgb);
+  kindMutex.lock();
+  quint16 id;
+  auto it = kindIDs.constFind(key);
+  if (it != kindIDs.constEnd()) {
+    id = it.value();
+  } else if (numKinds < MAX_KINDS) {
+    id = numKinds;
+    kinds[id] = new Kind(kind);
+    numKinds++;
+    kindIDs.insert(key, id);
+  } else {
+    id = MAX_KINDS - 1;  // table is full, reuse the last kind
+  }
+  kindMutex.unlock();
+  return id;
+}
+
+const Entity::Kind &Entity::getKind(quint16 id) {
+  return *kinds[id];
+}
+
+bool Entity::TryParse(const Tag* tag, EntityRecord *record) {
   EntityIdentifier& ei = EntityIdentifier::Instance();
 
-  QSharedPointer<OverlayItem> ret;
   auto pos = tag->at("Pos");
   if (pos && pos != &NBT::Null) {
-    Entity* entity = new Entity();
-    entity->pos.x = pos->at(0)->toDouble();
-    entity->pos.y = pos->at(1)->toDouble();
-    entity->pos.z = pos->at(2)->toDouble();
     auto id = tag->at("id");
     if (id && id != &NBT::Null) {
       QString type = id->toString().toLower().remove("minecraft:");
       EntityInfo const & info = ei.getEntityInfo(type);
 
-      QMap<QString, QVariant> props = tag->getData().toMap();
-
+      Kind kind;
+      kind.id = type;
       // get something more descriptive if its an item
       if (type == "item") {
         auto itemId = tag->at("Item")->at("id");
 
         QString itemtype = itemId->toString();
-        entity->setDisplay(itemtype.mid(itemtype.indexOf(':') + 1));
+        kind.display = itemtype.mid(itemtype.indexOf(':') + 1);
       } else {  // or just use the Entity's name
         if (info.name == "Name unknown")
-          entity->setDisplay(type);       // use Minecraft internal name if not found
+          kind.display = type;       // use Minecraft internal name if not found
         else
-          entity->setDisplay(info.name);  // use name as defined in JSON
+          kind.display = info.name;  // use name as defined in JSON
       }
-      entity->setType("Entity." + info.category);
-      entity->setColor(info.brushColor);
-      entity->setExtraColor(info.penColor);
-      entity->setProperties(props);
-      ret.reset(entity);
+      kind.type = "Entity." + info.category;
+      kind.brushColor = info.brushColor;
+      kind.penColor = info.penColor;
+
+      record->x = pos->at(0)->toDouble();
+      record->y = pos->at(1)->toDouble();
+      record->z = pos->at(2)->toDouble();
+      record->kind = internKind(kind);
+      return true;
     }
   }
-  return ret;
+  return false;
+}
+
+QSharedPointer<OverlayItem> Entity::fromRecord(const EntityRecord &record,
+                                               int chunkX, int chunkZ) {
+  const Kind &kind = getKind(record.kind);
+  Entity* entity = new Entity();
+  entity->record = record;
+  entity->chunkX = chunkX;
+  entity->chunkZ = chunkZ;
+  entity->setType(kind.type);
+  entity->setDisplay(kind.display);
+  entity->setColor(kind.brushColor);
+  return QSharedPointer<OverlayItem>(entity);
+}
+
+QVariant Entity::properties() const {
+  // parse the compressed Chunk data, which is read again when it is not
+  // in memory any more (blocking, called in the I/O pool by MapView)
+  QByteArray data;
+  if (!ChunkCache::Instance().readRaw(chunkX, chunkZ, &data))
+    return QVariant();
+
+  NBT nbt(reinterpret_cast<const uchar*>(data.constData()));
+  if (!nbt.has("Level"))
+    return QVariant();
+  auto entitylist = nbt.at("Level")->at("Entities");
+  if (!entitylist || entitylist == &NBT::Null)
+    return QVariant();
+
+  // the data might be newer than our record, so search if it moved
+  if (record.index < entitylist->length() &&
+      matches(entitylist->at(record.index)))
+    return entitylist->at(record.index)->getData();
+  for (int i = 0; i < entitylist->length(); i++) {
+    if (matches(entitylist->at(i)))
+      return entitylist->at(i)->getData();
+  }
+  return QVariant();
+}
+
+bool Entity::matches(const Tag *tag) const {
+  auto id = tag->at("id");
+  auto pos = tag->at("Pos");
+  if (!id || id == &NBT::Null || !pos || pos == &NBT::Null)
+    return false;
+  return id->toString().toLower().remove("minecraft:") ==
+             getKind(record.kind).id &&
+         pos->at(0)->toDouble() == record.x &&
+         pos->at(1)->toDouble() == record.y &&
+         pos->at(2)->toDouble() == record.z;
 }
 
 
 bool Entity::intersects(const Point& min, const Point& max) const {
-  return min.x <= pos.x && max.x >= pos.x &&
-      min.y <= pos.y && max.y >= pos.y &&
-      min.z <= pos.z && max.z >= pos.z;
+  return min.x <= record.x && max.x >= record.x &&
+      min.y <= record.y && max.y >= record.y &&
+      min.z <= record.z && max.z >= record.z;
 }
 
 void Entity::draw(double offsetX, double offsetZ, double scale,
                   QPainter *canvas) const {
-  QPoint center((pos.x - offsetX) * scale,
-                (pos.z - offsetZ) * scale);
+  draw(record, offsetX, offsetZ, scale, canvas);
+}
+
+void Entity::draw(const EntityRecord &record,
+                  double offsetX, double offsetZ, double scale,
+                  QPainter *canvas) {
+  const Kind &kind = getKind(record.kind);
+  QPoint center((record.x - offsetX) * scale,
+                (record.z - offsetZ) * scale);
 
-  QColor penColor = extraColor;
+  QColor penColor = kind.penColor;
   penColor.setAlpha(192);
   QPen pen = canvas->pen();
   pen.setColor(penColor);
   pen.setWidth(2);
   canvas->setPen(pen);
 
-  QColor brushColor = color();
+  QColor brushColor = kind.brushColor;
   brushColor.setAlpha(128);
   canvas->setBrush(brushColor);
   canvas->drawEllipse(center, RADIUS, RADIUS);
 }
 
 Entity::Point Entity::midpoint() const {
-  return pos;
+  return Point(record.x, record.y, record.z);
+}
+
+void Entity::bounds(Point *min, Point *max) const {
+  *min = midpoint();
+  *max = midpoint();
 }
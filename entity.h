@@ -7,15 +7,41 @@
 
 class Tag;
 
+// compact storage of a single Entity inside a Chunk
+// everything descriptive is shared between all Entities of the same kind
+struct EntityRecord {
+  double  x, y, z;
+  quint16 kind;   // see Entity::getKind()
+  quint16 index;  // position in the list of Entities in the Chunk NBT
+};
+
 class Entity: public OverlayItem {
  public:
-  static QSharedPointer<OverlayItem> TryParse(const Tag* tag);
+  // shared descriptive data of Entities
+  struct Kind {
+    QString id;       // Minecraft id without namespace
+    QString type;
+    QString display;
+    QColor  brushColor;
+    QColor  penColor;
+  };
+
+  static bool TryParse(const Tag* tag, EntityRecord *record);
+  static const Kind &getKind(quint16 id);
+  // create an OverlayItem for a record of the given Chunk
+  static QSharedPointer<OverlayItem> fromRecord(const EntityRecord &record,
+                                                int chunkX, int chunkZ);
+  static void draw(const EntityRecord &record,
+                   double offsetX, double offsetZ, double scale,
+                   QPainter *canvas);
 
   virtual bool intersects(const Point& min, const Point& max) const;
   virtual void draw(double offsetX, double offsetZ, double scale,
                     QPainter *canvas) const;
   virtual Point midpoint() const;
-  void setExtraColor(const QColor& c) {extraColor = c;}
+  virtual void bounds(Point *min, Point *max) const;
+  // properties are parsed on demand from the Chunk NBT
+  virtual QVariant properties() const;
 
   static const int RADIUS = 5;
 
@@ -23,9 +49,12 @@ class Entity: public OverlayItem {
   Entity() {}
 
  private:
-  QColor extraColor;
-  Point pos;
-  QString display;
+  static quint16 internKind(const Kind &kind);
+  // check that the NBT of an Entity belongs to our record
+  bool matches(const Tag *tag) const;
+
+  EntityRecord record;
+  int chunkX, chunkZ;
 };
 
 #endif  // ENTITY_H_
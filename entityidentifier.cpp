@@ -2,6 +2,7 @@
 #include <QDebug>
 #include <assert.h>
 #include "./entityidentifier.h"
+#include "./definitioncache.h"
 #include "./json.h"
 
 EntityInfo::EntityInfo(QString name, QString category, QColor brushColor,
@@ -43,27 +44,100 @@ void EntityIdentifier::disableDefinitions(int packID) {
   }
 }
 
-int EntityIdentifier::addDefinitions(JSONArray *defs, int packID) {
-  if (packID == -1) {
-    // find largest used packID
-    for (auto it = packs.constBegin(); it != packs.constEnd(); ++it) {
-      if (it->packID > packID)
-        packID = it->packID;
-    }
-    packID++;  // use one higher than largest found
-    packs.append(TpackInfo(packID));
+int EntityIdentifier::addPack() {
+  // find largest used packID
+  int packID = -1;
+  for (auto it = packs.constBegin(); it != packs.constEnd(); ++it) {
+    if (it->packID > packID)
+      packID = it->packID;
   }
+  packID++;  // use one higher than largest found
+  packs.append(TpackInfo(packID));
+  return packID;
+}
+
+int EntityIdentifier::addDefinitions(JSONArray *defs, int packID) {
+  if (packID == -1)
+    packID = addPack();
   int len = defs->length();
   for (int i = 0; i < len; i++)
     parseCategoryDefinition(dynamic_cast<JSONObject *>(defs->at(i)), packID);
   return packID;
 }
 
-EntityIdentifier::TentityMap& EntityIdentifier::getMapForPackID(int packID) {
+int EntityIdentifier::addDefinitions(const DefinitionCache &cache,
+                                     const CachedTable &categories,
+                                     const CachedTable &entities,
+                                     int packID) {
+  if (packID == -1)
+    packID = addPack();
+  TpackInfo *pack = getPackInfo(packID);
+  if (pack == NULL)
+    return packID;
+
+  const CachedCategory *cats = cache.getRecords<CachedCategory>(categories);
+  for (quint32 i = 0; i < categories.count; i++) {
+    QPair<QString, QColor> cat(cache.getString(cats[i].name),
+                               QColor::fromRgba(cats[i].color));
+    addCategory(cat);
+    pack->categories.append(cat);
+  }
+
+  const CachedEntity *records = cache.getRecords<CachedEntity>(entities);
+  for (quint32 i = 0; i < entities.count; i++) {
+    const CachedEntity &e = records[i];
+    pack->map.insert(cache.getString(e.id),
+                     EntityInfo(cache.getString(e.name),
+                                cache.getString(e.category),
+                                QColor::fromRgba(e.brushColor),
+                                QColor::fromRgba(e.penColor)));
+  }
+  return packID;
+}
+
+void EntityIdentifier::compileDefinitions(int packID, DefinitionCache *cache,
+                                          CachedTable *categories,
+                                          CachedTable *entities) const {
+  QVector<CachedCategory> cats;
+  QVector<CachedEntity> records;
+  for (auto pack = packs.constBegin(); pack != packs.constEnd(); ++pack) {
+    if (pack->packID != packID)
+      continue;
+    for (auto it = pack->categories.constBegin();
+         it != pack->categories.constEnd(); ++it) {
+      CachedCategory c;
+      memset(&c, 0, sizeof(c));
+      c.name = cache->addString(it->first);
+      c.color = it->second.rgba();
+      cats.append(c);
+    }
+    for (auto it = pack->map.constBegin(); it != pack->map.constEnd(); ++it) {
+      CachedEntity e;
+      memset(&e, 0, sizeof(e));
+      e.id = cache->addString(it.key());
+      e.name = cache->addString(it->name);
+      e.category = cache->addString(it->category);
+      e.brushColor = it->brushColor.rgba();
+      e.penColor = it->penColor.rgba();
+      records.append(e);
+    }
+  }
+  *categories = cache->addRecords(cats);
+  *entities = cache->addRecords(records);
+}
+
+EntityIdentifier::TpackInfo *EntityIdentifier::getPackInfo(int packID) {
   for (auto it = packs.begin(); it != packs.end(); ++it) {
     if (it->packID == packID)
-      return it->map;
+      return &(*it);
   }
+  return NULL;
+}
+
+EntityIdentifier::TentityMap& EntityIdentifier::getMapForPackID(int packID) {
+  TpackInfo *pack = getPackInfo(packID);
+  if (pack != NULL)
+    return pack->map;
   return dummyMap;
 }
 
@@ -84,6 +158,9 @@ void EntityIdentifier::parseCategoryDefinition(JSONObject *data, int packID) {
     catcolor.setHsv(hue % 360, 255, 255);
   }
   addCategory(qMakePair(category, catcolor));
+  TpackInfo *pack = getPackInfo(packID);
+  if (pack != NULL)
+    pack->categories.append(qMakePair(category, catcolor));
 
   if (data->has("entity")) {
     JSONArray *entities = dynamic_cast<JSONArray *>(data->at("entity"));
@@ -9,6 +9,8 @@
 
 class JSONArray;
 class JSONObject;
+class DefinitionCache;
+struct CachedTable;
 
 
 class EntityInfo {
@@ -27,6 +29,12 @@ class EntityIdentifier {
   static EntityIdentifier &Instance();
 
   int addDefinitions(JSONArray *, int packID = -1);
+  int addDefinitions(const DefinitionCache &cache,
+                     const CachedTable &categories,
+                     const CachedTable &entities, int packID = -1);
+  void compileDefinitions(int packID, DefinitionCache *cache,
+                          CachedTable *categories,
+                          CachedTable *entities) const;
   void enableDefinitions(int id);
   void disableDefinitions(int id);
 
@@ -63,10 +71,13 @@ class EntityIdentifier {
     int        packID;
     bool       enabled;
     TentityMap map;
+    TcatList   categories;  // as defined by this pack
     explicit TpackInfo(int packID) : packID(packID), enabled(true) {}
   };
   QList< TpackInfo > packs;
+  TpackInfo *getPackInfo(int packID);
   TentityMap& getMapForPackID(int packID);
+  int addPack();
 };
 
 #endif  // ENTITYIDENTIFIER_H_
@@ -5,6 +5,7 @@
 #include <cmath>
 
 #include "./flatteningconverter.h"
+#include "./definitioncache.h"
 #include "./json.h"
 
 
@@ -113,3 +114,30 @@ void FlatteningConverter::parseDefinition(
     }
   }
 }
+
+void FlatteningConverter::addDefinitions(const DefinitionCache &cache,
+                                         const CachedTable &table) {
+  const CachedPaletteEntry *records =
+      cache.getRecords<CachedPaletteEntry>(table);
+  for (quint32 i = 0; i < table.count; i++) {
+    int bid = records[i].bid;
+    if (bid >= 16*256) continue;
+    palette[bid].name = cache.getString(records[i].name);
+    palette[bid].hid  = records[i].hid;
+  }
+}
+
+CachedTable FlatteningConverter::compileDefinitions(
+    DefinitionCache *cache) const {
+  QVector<CachedPaletteEntry> records;
+  for (int bid = 0; bid < 16*256; bid++) {
+    if (palette[bid].name.isEmpty()) continue;
+    CachedPaletteEntry p;
+    memset(&p, 0, sizeof(p));
+    p.bid  = bid;
+    p.hid  = palette[bid].hid;
+    p.name = cache->addString(palette[bid].name);
+    records.append(p);
+  }
+  return cache->addRecords(records);
+}
@@ -6,6 +6,8 @@
 
 class JSONArray;
 class JSONObject;
+class DefinitionCache;
+struct CachedTable;
 
 
 class FlatteningConverter {
@@ -14,6 +16,9 @@ public:
   static FlatteningConverter &Instance();
 
   int addDefinitions(JSONArray *, int pack = -1);
+  // the palette is merged over all packs, so it is cached as a whole
+  void addDefinitions(const DefinitionCache &cache, const CachedTable &table);
+  CachedTable compileDefinitions(DefinitionCache *cache) const;
   void enableDefinitions(int id);
   void disableDefinitions(int id);
 //  const BlockData * getPalette();
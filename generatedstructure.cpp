@@ -73,11 +73,7 @@ GeneratedStructure::tryParseFeatures(QVariant &maybeFeatureMap) {
             structure->setDisplay(id);
             structure->setProperties(featureProperties);
 
-            // base the color on a hash of its type
-            int    hue = qHash(id) % 360;
-            QColor color;
-            color.setHsv(hue, 255, 255, 64);
-            structure->setColor(color);
+            structure->setColor(getColor(id));
 
             // this will have to be maintained if new structures are added
             // that are appearing only a some Dimensions
@@ -97,6 +93,14 @@ GeneratedStructure::tryParseFeatures(QVariant &maybeFeatureMap) {
   return ret;
 }
 
+// base the color on a hash of its type
+QColor GeneratedStructure::getColor(const QString &id) {
+  int    hue = qHash(id) % 360;
+  QColor color;
+  color.setHsv(hue, 255, 255, 64);
+  return color;
+}
+
 bool GeneratedStructure::intersects(const Point& min,
                                     const Point& max) const {
   return min.x <= p2.x && p1.x <= max.x &&
@@ -124,3 +128,8 @@ void GeneratedStructure::draw(double offsetX, double offsetZ, double scale,
 GeneratedStructure::Point GeneratedStructure::midpoint() const {
   return Point((p1.x + p2.x) / 2, (p1.y + p2.y) / 2, (p1.z + p2.z) / 2);
 }
+
+void GeneratedStructure::bounds(Point *min, Point *max) const {
+  *min = p1;
+  *max = p2;
+}
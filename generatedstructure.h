@@ -14,11 +14,13 @@ class GeneratedStructure: public OverlayItem {
   static QList<QSharedPointer<GeneratedStructure>> tryParseDatFile(const Tag* tag);
   static QList<QSharedPointer<GeneratedStructure>> tryParseChunk(const Tag* tag);
   static QList<QSharedPointer<GeneratedStructure>> tryParseFeatures(QVariant &maybeFeatureMap);
+  static QColor getColor(const QString &id);
 
   virtual bool intersects(const Point& min, const Point& max) const;
   virtual void draw(double offsetX, double offsetZ, double scale,
                    QPainter *canvas) const;
   virtual Point midpoint() const;
+  virtual void bounds(Point *min, Point *max) const;
 
  protected:
   GeneratedStructure() {}
@@ -0,0 +1,201 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include <QApplication>
+#include <QDebug>
+#include <QFile>
+#include <QMouseEvent>
+#include <QTextStream>
+#include <QTimer>
+#include <QWheelEvent>
+#include <algorithm>
+
+#include "./interactionreplay.h"
+#include "./mapview.h"
+#include "./minutor.h"
+#include "./perfcounters.h"
+
+InteractionReplay::InteractionReplay(Minutor *minutor)
+  : QObject(minutor)
+  , minutor(minutor)
+  , map(minutor->getMapview())
+  , current(0)
+{}
+
+bool InteractionReplay::load(const QString &filename) {
+  QFile f(filename);
+  if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    qWarning() << "Replay script not found:" << filename;
+    return false;
+  }
+  script = filename;
+  QTextStream in(&f);
+  int lineNumber = 0;
+  while (!in.atEnd()) {
+    QString line = in.readLine().section('#', 0, 0).trimmed();
+    lineNumber++;
+    if (line.isEmpty())
+      continue;
+    QStringList words = line.split(QRegExp("\\s+"));
+    Step step;
+    step.command = words.takeFirst().toLower();
+    if (step.command == "flag" && words.size() == 2) {
+      // keep the flag name as first word
+      step.command += " " + words[0].toLower();
+      step.args.append(words[1].toLower() == "on" ? 1 : 0);
+    } else {
+      for (auto &word : words)
+        step.args.append(word.toInt());
+    }
+    static const QStringList known = { "pan", "zoom", "depth", "jump",
+                                       "wait", "settle" };
+    if (!known.contains(step.command) && !step.command.startsWith("flag ")) {
+      qWarning() << "Replay script" << filename << "line" << lineNumber
+                 << "unknown command:" << line;
+      return false;
+    }
+    steps.append(step);
+  }
+  return !steps.isEmpty();
+}
+
+void InteractionReplay::start() {
+  current = 0;
+  frames.clear();
+  settleTimes.clear();
+  PerfCounters::Instance().reset();
+  QTimer::singleShot(0, this, SLOT(nextStep()));
+}
+
+void InteractionReplay::nextStep() {
+  if (current >= steps.size()) {
+    report();
+    qApp->quit();
+    return;
+  }
+  const Step &step = steps[current++];
+  if (step.command == "settle") {
+    settleTimer.start();
+    checkSettled();
+    return;
+  }
+  runStep(step);
+  int delay = FRAME_MS;
+  if (step.command == "wait" && !step.args.isEmpty())
+    delay = step.args[0];
+  QTimer::singleShot(delay, this, SLOT(nextStep()));
+}
+
+// wait until all visible Chunks are loaded and rendered with current settings
+void InteractionReplay::checkSettled() {
+  bool timeout = settleTimer.elapsed() > SETTLE_TIMEOUT_MS;
+  if (map->countPendingChunks() > 0 && !timeout) {
+    QTimer::singleShot(FRAME_MS, this, SLOT(checkSettled()));
+    return;
+  }
+  settleTimes.append(timeout ? QString("timeout")
+                             : QString("%1 ms").arg(settleTimer.elapsed()));
+  QTimer::singleShot(0, this, SLOT(nextStep()));
+}
+
+void InteractionReplay::runStep(const Step &step) {
+  const QVector<int> &a = step.args;
+  QElapsedTimer timer;
+  if (step.command == "pan" && a.size() >= 2) {
+    pan(a[0], a[1], a.size() > 2 ? qMax(1, a[2]) : 1);
+  } else if (step.command == "zoom" && a.size() >= 1) {
+    zoom(a[0]);
+  } else if (step.command == "depth" && a.size() >= 1) {
+    timer.start();
+    minutor->setDepth(a[0]);
+    measure(&timer);
+  } else if (step.command == "jump" && a.size() >= 2) {
+    timer.start();
+    minutor->jumpToXZ(a[0], a[1]);
+    measure(&timer);
+  } else if (step.command.startsWith("flag ") && a.size() >= 1) {
+    timer.start();
+    setFlag(step.command.mid(5), a[0] != 0);
+    measure(&timer);
+  }
+}
+
+// drag with the left mouse button, one move event per frame
+void InteractionReplay::pan(int dx, int dz, int frames) {
+  QPointF pos(map->width() / 2, map->height() / 2);
+  QMouseEvent press(QEvent::MouseButtonPress, pos,
+                    Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+  QApplication::sendEvent(map, &press);
+  QPointF start = pos;
+  for (int i = 1; i <= frames; i++) {
+    // dragging moves the map against the mouse
+    QPointF to = start - QPointF(dx * i / frames, dz * i / frames);
+    QMouseEvent move(QEvent::MouseMove, to,
+                     Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+    QElapsedTimer timer;
+    timer.start();
+    QApplication::sendEvent(map, &move);
+    measure(&timer);
+    // let finished Chunks be composed in between like during a real drag
+    QApplication::processEvents();
+    pos = to;
+  }
+  QMouseEvent release(QEvent::MouseButtonRelease, pos,
+                      Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+  QApplication::sendEvent(map, &release);
+}
+
+void InteractionReplay::zoom(int steps) {
+  QPointF pos(map->width() / 2, map->height() / 2);
+  for (int i = 0; i < qAbs(steps); i++) {
+    QWheelEvent wheel(pos, steps > 0 ? 120 : -120,
+                      Qt::NoButton, Qt::NoModifier);
+    QElapsedTimer timer;
+    timer.start();
+    QApplication::sendEvent(map, &wheel);
+    measure(&timer);
+    QApplication::processEvents();
+  }
+}
+
+void InteractionReplay::setFlag(const QString &name, bool on) {
+  if (name == "lighting")
+    minutor->setViewLighting(on);
+  else if (name == "mobspawn")
+    minutor->setViewMobspawning(on);
+  else if (name == "cave")
+    minutor->setViewCavemode(on);
+  else if (name == "depthshading")
+    minutor->setViewDepthshading(on);
+  else if (name == "biome")
+    minutor->setViewBiomeColors(on);
+  else if (name == "singlelayer")
+    minutor->setSingleLayer(on);
+  else
+    qWarning() << "Replay: unknown flag" << name;
+}
+
+// a frame is the handling of one input event plus painting the result
+void InteractionReplay::measure(QElapsedTimer *timer) {
+  map->repaint();
+  frames.append(timer->nsecsElapsed());
+}
+
+double InteractionReplay::percentile(QVector<qint64> values, int percent) {
+  if (values.isEmpty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  int index = qMin(values.size() - 1, (values.size() * percent) / 100);
+  return values[index] / 1000000.0;
+}
+
+void InteractionReplay::report() {
+  QTextStream out(stdout);
+  out << "replay " << script << ": " << frames.size() << " frames, p50 "
+      << QString::number(percentile(frames, 50), 'f', 2) << " ms, p99 "
+      << QString::number(percentile(frames, 99), 'f', 2) << " ms\n";
+  for (int i = 0; i < settleTimes.size(); i++)
+    out << "settle " << (i + 1) << ": " << settleTimes[i] << "\n";
+  // GUI thread time spent in redraw and composeFrame is part of the stages
+  for (const QString &line : PerfCounters::Instance().report())
+    out << line << "\n";
+  out.flush();
+}
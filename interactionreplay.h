@@ -0,0 +1,68 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef INTERACTIONREPLAY_H_
+#define INTERACTIONREPLAY_H_
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+
+class Minutor;
+class MapView;
+
+// plays a scripted sequence of pan, zoom, depth and flag changes on the
+// MapView and reports frame times and the time until all Chunks are final
+//
+// script commands (one per line, '#' starts a comment):
+//   pan <dx> <dz> <frames>  drag by dx,dz pixels, spread over some frames
+//   zoom <steps>            mouse wheel steps, positive zooms in
+//   depth <y>               move the depth slider
+//   flag <name> on|off      lighting, mobspawn, cave, depthshading,
+//                           biome or singlelayer
+//   jump <x> <z>            jump to block coordinates
+//   wait <ms>               idle time
+//   settle                  wait until all visible Chunks are final
+//
+// started with "--replay <script>", the window is not shown: Minutor runs
+// on the offscreen platform plugin unless "-platform <name>" (or
+// QT_QPA_PLATFORM) selects another one, e.g. "-platform xcb" to watch
+class InteractionReplay : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit InteractionReplay(Minutor *minutor);
+
+  bool load(const QString &filename);
+  void start();
+
+ private slots:
+  void nextStep();
+  void checkSettled();
+
+ private:
+  struct Step {
+    QString command;
+    QVector<int> args;
+  };
+  void runStep(const Step &step);
+  void pan(int dx, int dz, int frames);
+  void zoom(int steps);
+  void setFlag(const QString &name, bool on);
+  void measure(QElapsedTimer *timer);
+  void report();
+  static double percentile(QVector<qint64> values, int percent);
+
+  static const int FRAME_MS = 16;             // pace of the input events
+  static const int SETTLE_TIMEOUT_MS = 60000;
+
+  Minutor *minutor;
+  MapView *map;
+  QString script;
+  QList<Step> steps;
+  int current;
+  QVector<qint64> frames;      // nanoseconds per input event incl. repaint
+  QStringList settleTimes;
+  QElapsedTimer settleTimer;
+};
+
+#endif  // INTERACTIONREPLAY_H_
@@ -1,6 +1,7 @@
 /** Copyright (c) 2013, Sean Kasun */
-#include <QFile>
-#include <QtCore>
+#include <QVector>
+#include <cstring>
+#include <new>
 #include "./json.h"
 
 enum Token {
@@ -17,37 +18,102 @@ enum Token {
   TokenValueSeparator
 };
 
+static JSONData Null;
+static const size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+// bump allocator for all nodes of one document, freed at once
+class JSONArena {
+ public:
+  JSONArena() : next(NULL), left(0) {}
+  ~JSONArena() {
+    for (char *block : blocks)
+      delete[] block;
+  }
+  void *alloc(size_t size) {
+    size = (size + 7) & ~size_t(7);
+    if (size > left) {
+      size_t blockSize = qMax(size, ARENA_BLOCK_SIZE);
+      next = new char[blockSize];
+      left = blockSize;
+      blocks.append(next);
+    }
+    void *p = next;
+    next += size;
+    left -= size;
+    return p;
+  }
+  template <class T, class... Args>
+  T *create(Args... args) {
+    return new (alloc(sizeof(T))) T(args...);
+  }
+  template <class T>
+  T *copy(const T *data, int count) {
+    T *p = static_cast<T *>(alloc(sizeof(T) * count));
+    if (count > 0)
+      memcpy(p, data, sizeof(T) * count);
+    return p;
+  }
+
+ private:
+  QVector<char *> blocks;
+  char *next;
+  size_t left;
+};
+
+// root of a parsed document, owns source bytes and arena
+class JSONDocument : public JSONData {
+ public:
+  explicit JSONDocument(const QByteArray &source) :
+    source(source), root(&Null) {}
+  bool has(const QString key) { return root->has(key); }
+  JSONData *at(const QString key) { return root->at(key); }
+  JSONData *at(int index) { return root->at(index); }
+  int length() { return root->length(); }
+
+  QByteArray source;
+  JSONArena arena;
+  JSONData *root;
+};
+
+struct JSONView {
+  const char *data;
+  int length;
+  bool ascii;
+};
+
 class JSONHelper {
  public:
-  explicit JSONHelper(QString data) : data(data) {
+  JSONHelper(const QByteArray &source, JSONArena *arena) :
+      data(source.constData()), arena(arena) {
     pos = 0;
-    len = data.length();
+    len = source.length();
+    // skip UTF-8 byte order mark
+    if (len >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+      pos = 3;
   }
-  ~JSONHelper() {}
   Token nextToken() {
-    while (pos < len && data.at(pos).isSpace())
+    while (pos < len && isSpace(data[pos]))
       pos++;
     if (pos == len)
       throw JSONParseException("Unexpected EOF", location());
-    QChar c = data.at(pos++);
-    if (c.isLetter()) {  // keyword like NULL,TRUE or FALSE
+    char c = data[pos++];
+    if (isLetter(c)) {  // keyword like NULL,TRUE or FALSE
       int start = pos - 1;
-      while (pos < len && data.at(pos).isLetter())
+      while (pos < len && isLetter(data[pos]))
         pos++;
-      QStringRef ref = data.midRef(start, pos - start);
-      if (ref.compare(QString("null"), Qt::CaseInsensitive) == 0)
+      if (isKeyword(start, "null"))
         return TokenNULL;
-      if (ref.compare(QString("true"), Qt::CaseInsensitive) == 0)
+      if (isKeyword(start, "true"))
         return TokenTRUE;
-      if (ref.compare(QString("false"), Qt::CaseInsensitive) == 0)
+      if (isKeyword(start, "false"))
         return TokenFALSE;
       throw JSONParseException("Unquoted string", location());
     }
-    if (c.isDigit() || c == '-') {  // double or hex
+    if (isDigit(c) || c == '-') {  // double or hex
       pos--;
       return TokenNumber;
     }
-    switch (c.unicode()) {
+    switch (c) {
       case '"': return TokenString;
       case '{': return TokenObject;
       case '}': return TokenObjectClose;
@@ -56,75 +122,95 @@ class JSONHelper {
       case ':': return TokenKeySeparator;
       case ',': return TokenValueSeparator;
       default:
-        throw JSONParseException(QString("Unexpected character: %1").arg(c),
-                                 location());
+        throw JSONParseException(
+            QString("Unexpected character: %1").arg(QLatin1Char(c)),
+            location());
     }
   }
-  QString readString() {
-    QString r;
-    while (pos < len && data.at(pos) != '"') {
-      if (data.at(pos) == '\\') {
-        pos++;
-        if (pos == len)
-          throw JSONParseException("Unexpected EOF", location());
-        switch (data.at(pos++).unicode()) {
-          case '"': r += '"'; break;
-          case '\\': r += '\\'; break;
-          case '/': r += '/'; break;
-          case 'b': r += '\b'; break;
-          case 'f': r += '\f'; break;
-          case 'n': r += '\n'; break;
-          case 'r': r += '\r'; break;
-          case 't': r += '\t'; break;
-          case 'u': {  // hex
-            int num = 0;
-            for (int i = 0; i < 4; i++) {
-              if (pos == len)
-                throw JSONParseException("Unexpected EOF", location());
-              num <<= 4;
-              char c = data.at(pos++).unicode();
-              if (c >= '0' && c <= '9')
-                num |= c - '0';
-              else if (c >= 'a' && c <= 'f')
-                num |= c - 'a' + 10;
-              else if (c >= 'A' && c <= 'F')
-                num |= c - 'A' + 10;
-              else
-                throw JSONParseException("Invalid hex code", location());
+  JSONView readString() {
+    // common case: no escapes, the string is a view into the source
+    int start = pos;
+    uchar bits = 0;
+    while (pos < len && data[pos] != '"' && data[pos] != '\\')
+      bits |= data[pos++];
+    if (pos == len)
+      throw JSONParseException("Unexpected EOF", location());
+    if (data[pos] == '"') {
+      JSONView view = {data + start, pos - start, bits < 0x80};
+      pos++;
+      return view;
+    }
+    // decoded escapes are never longer than their source
+    int end = pos;
+    while (end < len && data[end] != '"')
+      end += (data[end] == '\\') ? 2 : 1;
+    if (end >= len)
+      throw JSONParseException("Unexpected EOF", location());
+    char *out = static_cast<char *>(arena->alloc(end - start));
+    int olen = pos - start;
+    memcpy(out, data + start, olen);
+    while (data[pos] != '"') {
+      if (data[pos] != '\\') {
+        bits |= data[pos];
+        out[olen++] = data[pos++];
+        continue;
+      }
+      pos++;
+      switch (data[pos++]) {
+        case '"': out[olen++] = '"'; break;
+        case '\\': out[olen++] = '\\'; break;
+        case '/': out[olen++] = '/'; break;
+        case 'b': out[olen++] = '\b'; break;
+        case 'f': out[olen++] = '\f'; break;
+        case 'n': out[olen++] = '\n'; break;
+        case 'r': out[olen++] = '\r'; break;
+        case 't': out[olen++] = '\t'; break;
+        case 'u': {  // hex
+          uint num = readHex();
+          // combine surrogate pairs into one code point
+          if (num >= 0xd800 && num < 0xdc00 && pos + 1 < end &&
+              data[pos] == '\\' && data[pos + 1] == 'u') {
+            pos += 2;
+            uint low = readHex();
+            if (low >= 0xdc00 && low < 0xe000) {
+              num = 0x10000 + ((num - 0xd800) << 10) + (low - 0xdc00);
+            } else {  // unpaired, keep both as they are
+              olen += encodeUtf8(num, out + olen);
+              num = low;
             }
-            r += QChar(num);
           }
-            break;
-          default:
-            throw JSONParseException("Unknown escape sequence", location());
+          olen += encodeUtf8(num, out + olen);
+          bits |= 0x80;
         }
-      } else {
-        r += data.at(pos++);
+          break;
+        default:
+          throw JSONParseException("Unknown escape sequence", location());
       }
     }
     pos++;
-    return r;
+    JSONView view = {out, olen, bits < 0x80};
+    return view;
   }
   double readDouble() {
     double sign = 1.0;
-    if (data.at(pos) == '-') {
+    if (data[pos] == '-') {
       sign = -1.0;
       pos++;
-    } else if (data.at(pos) == '+') {
+    } else if (data[pos] == '+') {
       pos++;
     }
     double value = 0.0;
-    while (pos < len && data.at(pos).isDigit()) {
+    while (pos < len && isDigit(data[pos])) {
       value *= 10.0;
-      value += data.at(pos++).unicode() - '0';
+      value += data[pos++] - '0';
     }
     if (pos == len)
       throw JSONParseException("Unexpected EOF", location());
-    if (data.at(pos) == '.') {
+    if (data[pos] == '.') {
       double pow10 = 10.0;
       pos++;
-      while (pos < len && data.at(pos).isDigit()) {
-        value += (data.at(pos++).unicode() - '0') / pow10;
+      while (pos < len && isDigit(data[pos])) {
+        value += (data[pos++] - '0') / pow10;
         pow10 *= 10.0;
       }
     }
@@ -132,20 +218,20 @@ class JSONHelper {
       throw JSONParseException("Unexpected EOF", location());
     double scale = 1.0;
     bool frac = false;
-    if (data.at(pos) == 'e' || data.at(pos) == 'E') {
+    if (data[pos] == 'e' || data[pos] == 'E') {
       pos++;
       if (pos == len)
         throw JSONParseException("Unexpected EOF", location());
-      if (data.at(pos) == '-') {
+      if (data[pos] == '-') {
         frac = true;
         pos++;
-      } else if (data.at(pos) == '+') {
+      } else if (data[pos] == '+') {
         pos++;
       }
       unsigned int expon = 0;
-      while (pos < len && data.at(pos).isDigit()) {
+      while (pos < len && isDigit(data[pos])) {
         expon *= 10.0;
-        expon += data.at(pos++).unicode() - '0';
+        expon += data[pos++] - '0';
       }
       if (expon > 308)
         expon = 308;
@@ -164,46 +250,167 @@ class JSONHelper {
     }
     return sign * (frac ? (value / scale) : (value * scale));
   }
+  JSONData *readValue(Token type) {
+    switch (type) {
+      case TokenNULL: return &Null;
+      case TokenTRUE: return arena->create<JSONBool>(true);
+      case TokenFALSE: return arena->create<JSONBool>(false);
+      case TokenString: {
+        JSONView s = readString();
+        return arena->create<JSONString>(s.data, s.length);
+      }
+      case TokenNumber: return arena->create<JSONNumber>(readDouble());
+      case TokenObject: return readObject();
+      case TokenArray: return readArray();
+      default: throw JSONParseException("Expected value", location());
+    }
+  }
+  JSONData *readObject() {
+    // children are collected on a shared stack and copied out when complete
+    int base = members.size();
+    while (true) {
+      Token type = nextToken();
+      if (type == TokenObjectClose)
+        break;
+      if (type != TokenString)
+        throw JSONParseException("Expected quoted string", location());
+      JSONView key = readString();
+      if (key.length == 0)
+        throw JSONParseException("Empty object key", location());
+      if (nextToken() != TokenKeySeparator)
+        throw JSONParseException("Expected ':'", location());
+      JSONMember member = {key.data, key.length, key.ascii, NULL};
+      member.value = readValue(nextToken());
+      members.append(member);
+      type = nextToken();  // comma or end
+      if (type == TokenObjectClose)
+        break;
+      if (type != TokenValueSeparator)
+        throw JSONParseException("Expected ',' or '}'", location());
+    }
+    int count = members.size() - base;
+    JSONMember *copy = arena->copy(members.constData() + base, count);
+    members.resize(base);
+    return arena->create<JSONObject>(copy, count);
+  }
+  JSONData *readArray() {
+    int base = items.size();
+    while (true) {
+      Token type = nextToken();
+      if (type == TokenArrayClose)
+        break;
+      items.append(readValue(type));
+      type = nextToken();  // comma or end
+      if (type == TokenArrayClose)
+        break;
+      if (type != TokenValueSeparator)
+        throw JSONParseException("Expected ',' or ']'", location());
+    }
+    int count = items.size() - base;
+    JSONData **copy = arena->copy(items.constData() + base, count);
+    items.resize(base);
+    return arena->create<JSONArray>(copy, count);
+  }
   QString location() {
     int line = 1;
     int col = 0;
-    if (len > 0)
-    {
-        int cpos = pos;
-        bool doneCol = false;
-        while (cpos >= 0) {
-          if (data.at(cpos) == '\n') {
-            doneCol = true;
-            line++;
-          }
-          if (!doneCol) col++;
-          cpos--;
-        }
+    bool doneCol = false;
+    for (int cpos = qMin(pos, len - 1); cpos >= 0; cpos--) {
+      if (data[cpos] == '\n') {
+        doneCol = true;
+        line++;
+      }
+      if (!doneCol) col++;
     }
     return QString("Line: %1, Offset: %2").arg(line).arg(col);
   }
 
  private:
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' ||
+           c == '\f' || c == '\v';
+  }
+  static bool isLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+  static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+  bool isKeyword(int start, const char *keyword) const {
+    int klen = strlen(keyword);
+    return pos - start == klen && qstrnicmp(data + start, keyword, klen) == 0;
+  }
+  uint readHex() {
+    uint num = 0;
+    for (int i = 0; i < 4; i++) {
+      if (pos == len)
+        throw JSONParseException("Unexpected EOF", location());
+      num <<= 4;
+      char c = data[pos++];
+      if (c >= '0' && c <= '9')
+        num |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        num |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        num |= c - 'A' + 10;
+      else
+        throw JSONParseException("Invalid hex code", location());
+    }
+    return num;
+  }
+  static int encodeUtf8(uint c, char *out) {
+    if (c < 0x80) {
+      out[0] = c;
+      return 1;
+    }
+    if (c < 0x800) {
+      out[0] = 0xc0 | (c >> 6);
+      out[1] = 0x80 | (c & 0x3f);
+      return 2;
+    }
+    if (c < 0x10000) {
+      out[0] = 0xe0 | (c >> 12);
+      out[1] = 0x80 | ((c >> 6) & 0x3f);
+      out[2] = 0x80 | (c & 0x3f);
+      return 3;
+    }
+    out[0] = 0xf0 | (c >> 18);
+    out[1] = 0x80 | ((c >> 12) & 0x3f);
+    out[2] = 0x80 | ((c >> 6) & 0x3f);
+    out[3] = 0x80 | (c & 0x3f);
+    return 4;
+  }
+
   int pos, len;
-  QString data;
+  const char *data;
+  JSONArena *arena;
+  QVector<JSONMember> members;  // open objects
+  QVector<JSONData *> items;    // open arrays
 };
 
-std::unique_ptr<JSONData> JSON::parse(const QString data) {
-  JSONHelper reader(data);
+std::unique_ptr<JSONData> JSON::parse(const QByteArray &data) {
+  std::unique_ptr<JSONDocument> doc(new JSONDocument(data));
+  JSONHelper reader(doc->source, &doc->arena);
   Token type = reader.nextToken();
   switch (type) {
     case TokenObject:  // hash
-      return std::make_unique<JSONObject>(reader);
+      doc->root = reader.readObject();
+      break;
     case TokenArray:  // array
-      return std::make_unique<JSONArray>(reader);
+      doc->root = reader.readArray();
+      break;
     default:
       throw JSONParseException("Doesn't start with object or array",
                                reader.location());
       break;
   }
-  return nullptr;
+  return doc;
 }
-static JSONData Null;
+
+std::unique_ptr<JSONData> JSON::parse(const QString data) {
+  return parse(data.toUtf8());
+}
+
 JSONData::JSONData() {
 }
 JSONData::~JSONData() {
@@ -237,11 +444,10 @@ bool JSONBool::asBool() {
   return data;
 }
 
-JSONString::JSONString(QString val) {
-  data = val;
+JSONString::JSONString(const char *val, int len) : data(val), len(len) {
 }
 QString JSONString::asString() {
-  return data;
+  return QString::fromUtf8(data, len);
 }
 
 JSONNumber::JSONNumber(double val) {
@@ -251,83 +457,48 @@ double JSONNumber::asNumber() {
   return data;
 }
 
-JSONObject::JSONObject(JSONHelper &reader) {
-  while (true) {
-    Token type = reader.nextToken();
-    if (type == TokenObjectClose)
-      break;
-    if (type != TokenString)
-      throw JSONParseException("Expected quoted string", reader.location());
-    QString key = reader.readString();
-    if (key.length() == 0)
-      throw JSONParseException("Empty object key", reader.location());
-    if (reader.nextToken() != TokenKeySeparator)
-      throw JSONParseException("Expected ':'", reader.location());
-    JSONData *value;
-    switch (reader.nextToken()) {
-      case TokenNULL: value = NULL; break;
-      case TokenTRUE: value = new JSONBool(true); break;
-      case TokenFALSE: value = new JSONBool(false); break;
-      case TokenString: value = new JSONString(reader.readString()); break;
-      case TokenNumber: value = new JSONNumber(reader.readDouble()); break;
-      case TokenObject: value = new JSONObject(reader); break;
-      case TokenArray: value = new JSONArray(reader); break;
-      default: throw JSONParseException("Expected value", reader.location());
+JSONObject::JSONObject(const JSONMember *members, int count) :
+    members(members), count(count) {
+}
+const JSONMember *JSONObject::find(const QString &key) const {
+  // objects are small, a linear scan beats hashing every key while parsing
+  // search backwards, with duplicate keys the last one wins
+  for (int i = count - 1; i >= 0; i--) {
+    const JSONMember &m = members[i];
+    if (!m.ascii) {
+      if (QString::fromUtf8(m.key, m.keyLength) == key)
+        return &m;
+      continue;
     }
-    children[key] = value;
-    type = reader.nextToken();  // comma or end
-    if (type == TokenObjectClose)
-      break;
-    if (type != TokenValueSeparator)
-      throw JSONParseException("Expected ',' or '}'", reader.location());
+    if (m.keyLength != key.length())
+      continue;
+    const QChar *k = key.constData();
+    int j = 0;
+    while (j < m.keyLength && k[j].unicode() == uchar(m.key[j]))
+      j++;
+    if (j == m.keyLength)
+      return &m;
   }
-}
-JSONObject::~JSONObject() {
-  for (auto i = children.constBegin(); i != children.constEnd(); i++)
-    delete i.value();
+  return NULL;
 }
 bool JSONObject::has(QString key) {
-  return children.contains(key);
+  return find(key) != NULL;
 }
 JSONData *JSONObject::at(QString key) {
-  if (children.contains(key))
-    return children[key];
+  const JSONMember *m = find(key);
+  if (m != NULL)
+    return m->value;
   return &Null;
 }
 
-JSONArray::JSONArray(JSONHelper &reader) {
-  while (true) {
-    Token type = reader.nextToken();
-    if (type == TokenArrayClose)
-      break;
-    JSONData *value;
-    switch (type) {
-      case TokenNULL: value = NULL; break;
-      case TokenTRUE: value = new JSONBool(true); break;
-      case TokenFALSE: value = new JSONBool(false); break;
-      case TokenString: value = new JSONString(reader.readString()); break;
-      case TokenNumber: value = new JSONNumber(reader.readDouble()); break;
-      case TokenObject: value = new JSONObject(reader); break;
-      case TokenArray: value = new JSONArray(reader); break;
-      default: throw JSONParseException("Expected Value", reader.location());
-    }
-    data.append(value);
-    type = reader.nextToken();  // comma or end
-    if (type == TokenArrayClose)
-      break;
-    if (type != TokenValueSeparator)
-      throw JSONParseException("Expected ',' or ']'", reader.location());
-  }
-}
-JSONArray::~JSONArray() {
-  for (auto i = data.constBegin(); i != data.constEnd(); i++)
-    delete *i;
+JSONArray::JSONArray(JSONData * const *items, int count) :
+    items(items), count(count) {
 }
 int JSONArray::length() {
-  return data.length();
+  return count;
 }
 JSONData *JSONArray::at(int index) {
-  if (index < data.length())
-    return data[index];
+  if (index >= 0 && index < count)
+    return items[index];
   return &Null;
 }
@@ -2,11 +2,13 @@
 #ifndef JSON_H_
 #define JSON_H_
 
-#include <QHash>
-#include <QList>
+#include <QByteArray>
+#include <QString>
 #include <memory>
 
-class JSONHelper;
+// All nodes of one parsed document live in a single arena that is owned
+// by the returned root. Strings are UTF-8 views into the source bytes and
+// are only converted to QString when asked for.
 
 class JSONData {
  public:
@@ -31,10 +33,11 @@ class JSONBool : public JSONData {
 
 class JSONString : public JSONData {
  public:
-  explicit JSONString(QString val);
+  JSONString(const char *val, int len);  // UTF-8, not owned
   QString asString();
  private:
-  QString data;
+  const char *data;
+  int len;
 };
 
 class JSONNumber : public JSONData {
@@ -45,23 +48,31 @@ class JSONNumber : public JSONData {
   double data;
 };
 
+struct JSONMember {
+  const char *key;  // UTF-8, not owned
+  int keyLength;
+  bool ascii;       // key can be compared byte by byte
+  JSONData *value;
+};
+
 class JSONObject : public JSONData {
  public:
-  explicit JSONObject(JSONHelper &);
-  ~JSONObject();
+  JSONObject(const JSONMember *members, int count);
   bool has(const QString key);
   JSONData *at(const QString key);
  private:
-  QHash<QString, JSONData *>children;
+  const JSONMember *find(const QString &key) const;
+  const JSONMember *members;
+  int count;
 };
 class JSONArray : public JSONData {
  public:
-  explicit JSONArray(JSONHelper &);
-  ~JSONArray();
+  JSONArray(JSONData * const *items, int count);
   JSONData *at(int index);
   int length();
  private:
-  QList<JSONData *>data;
+  JSONData * const *items;
+  int count;
 };
 
 class JSONParseException {
@@ -73,6 +84,7 @@ class JSONParseException {
 
 class JSON {
  public:
+  static std::unique_ptr<JSONData> parse(const QByteArray &data);  // UTF-8
   static std::unique_ptr<JSONData> parse(const QString data);
 };
 
@@ -4,8 +4,24 @@
 #include <QLocale>
 
 #include "./minutor.h"
+#include "./interactionreplay.h"
+#include "./tracerecorder.h"
+#include "./workerpools.h"
 
 int main(int argc, char *argv[]) {
+  // a replay measures the view without showing a window, unless another
+  // platform plugin is requested explicitly
+  bool platform = qEnvironmentVariableIsSet("QT_QPA_PLATFORM");
+  bool replaying = false;
+  for (int i = 1; i < argc; i++) {
+    if (qstrcmp(argv[i], "-platform") == 0)
+      platform = true;
+    if (qstricmp(argv[i], "--replay") == 0)
+      replaying = true;
+  }
+  if (replaying && !platform)
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
   QApplication app(argc, argv);
 
   QString locale = QLocale::system().name();
@@ -18,17 +34,24 @@ int main(int argc, char *argv[]) {
   app.setApplicationVersion("2.3.0");
   app.setOrganizationName("seancode");
 
-  Minutor minutor;
-
   // Process the cmdline arguments:
   QStringList args = app.arguments();
   int numArgs = args.size();
+
+  // tracing has to start before the first Chunk is loaded
+  int trace = args.indexOf("--trace");
+  if (trace >= 0 && trace + 1 < numArgs)
+    TraceRecorder::Instance().start(args[trace + 1]);
+
+  Minutor minutor;
+
   int ex_Xmin = 0;
   int ex_Xmax = 0;
   int ex_Zmin = 0;
   int ex_Zmax = 0;
   bool regionChecker = false;
   bool chunkChecker = false;
+  QString replayScript;
   for (int i = 0; i < numArgs; i++) {
     if (args[i].length() > 2) {
       // convert long variants to lower case
@@ -47,6 +70,28 @@ int main(int argc, char *argv[]) {
       chunkChecker = true;
       continue;
     }
+    // thread counts for this session only (0 = adaptive)
+    if (args[i] == "--iothreads" && i + 1 < numArgs) {
+      WorkerPools::Instance().setThreadCount(WorkerPools::stageIO,
+                                             args[i + 1].toInt());
+      i += 1;
+      continue;
+    }
+    if (args[i] == "--cputhreads" && i + 1 < numArgs) {
+      WorkerPools::Instance().setThreadCount(WorkerPools::stageCPU,
+                                             args[i + 1].toInt());
+      i += 1;
+      continue;
+    }
+    if (args[i] == "--replay" && i + 1 < numArgs) {
+      replayScript = args[i + 1];
+      i += 1;
+      continue;
+    }
+    if (args[i] == "--trace" && i + 1 < numArgs) {
+      i += 1;  // already handled
+      continue;
+    }
     if ((args[i] == "-r" || args[i] == "--exportrange") && i + 4 < numArgs) {
       ex_Xmin = args[i + 1].toInt();
       ex_Xmax = args[i + 2].toInt();
@@ -100,5 +145,15 @@ int main(int argc, char *argv[]) {
   }
 
   minutor.show();
-  return app.exec();
+
+  // benchmark a scripted interaction, quits when done
+  if (!replayScript.isEmpty()) {
+    InteractionReplay *replay = new InteractionReplay(&minutor);
+    if (replay->load(replayScript))
+      replay->start();
+  }
+
+  int result = app.exec();
+  TraceRecorder::Instance().write();
+  return result;
 }
@@ -2,11 +2,17 @@
 #include <QPainter>
 #include <QResizeEvent>
 #include <QMessageBox>
+#include <QDebug>
 #include <assert.h>
 
 #include "./mapview.h"
 #include "./chunkcache.h"
 #include "./chunkrenderer.h"
+#include "./rendercache.h"
+#include "./mobspawn.h"
+#include "./perfcounters.h"
+#include "./tracerecorder.h"
+#include "./workerpools.h"
 #include "./definitionmanager.h"
 #include "./blockidentifier.h"
 #include "./biomeidentifier.h"
@@ -15,14 +21,37 @@
 MapView::MapView(QWidget *parent)
   : QWidget(parent)
   , cache(ChunkCache::Instance())
+  , renderCache(RenderCache::Instance())
 {
   depth = 255;
   scale = 1;
   zoom = 1.0;
+  panAheadX = 0.0;
+  panAheadZ = 0.0;
+  scrollX = 0;
+  scrollY = 0;
+  overlaysClear = false;
+  progressive = QSettings().value("progressive", true).toBool();
+  coarseTiles.setMaxCost(COARSE_TILES_MAX);
+  coarseDimension = 0;
+  frameScheduled = false;
+  overlaysOutdated = false;
+  showPerformance = false;
+  perfTimer.setInterval(PERF_HUD_INTERVAL_MS);
+  connect(&perfTimer, SIGNAL(timeout()),
+          this,       SLOT(update()));
+  frameTimer.setSingleShot(true);
+  frameTimer.setInterval(FRAME_INTERVAL_MS);
+  connect(&frameTimer, SIGNAL(timeout()),
+          this,        SLOT(composeFrame()));
   connect(&cache, SIGNAL(chunkLoaded(int, int)),
-          this,   SLOT  (chunkUpdated(int, int)));
+          this,   SLOT  (chunkUpdated(int, int)), Qt::DirectConnection);
+  connect(&cache, SIGNAL(chunkPartsLoaded(int, int)),
+          this,   SLOT  (chunkPartsUpdated(int, int)), Qt::DirectConnection);
   connect(&cache, SIGNAL(structureFound(QSharedPointer<GeneratedStructure>)),
           this,   SLOT  (addStructureFromChunk(QSharedPointer<GeneratedStructure>)));
+  connect(&cache, SIGNAL(structureTypeFound(QString, QColor)),
+          this,   SIGNAL(addOverlayItemType(QString, QColor)));
   setMouseTracking(true);
   setFocusPolicy(Qt::StrongFocus);
 
@@ -56,7 +85,7 @@ QSize MapView::sizeHint() const {
 void MapView::attach(DefinitionManager *dm) {
   this->dm = dm;
   connect(dm, SIGNAL(packsChanged()),
-          this, SLOT(redraw()));
+          this, SLOT(updateDefinitions()));
 }
 
 void MapView::setLocation(double x, double z) {
@@ -95,6 +124,10 @@ void MapView::setDimension(QString path, int scale) {
     this->x = 0;  // and we jump to the center spawn automatically
     this->z = 0;
   }
+  // keep coarse approximations of each dimension for the next visit
+  if (!coarseDimensions.contains(path))
+    coarseDimensions.insert(path, coarseDimensions.size());
+  coarseDimension = coarseDimensions.value(path);
   cache.clear();
   cache.setPath(path);
   redraw();
@@ -117,8 +150,62 @@ int MapView::getDepth() const {
   return depth;
 }
 
+// called for every loaded or rendered Chunk, also from worker threads
 void MapView::chunkUpdated(int x, int z) {
-  drawChunk(x, z);
+  pendingMutex.lock();
+  pendingChunks.insert(ChunkID(x, z));
+  bool schedule = !frameScheduled;
+  frameScheduled = true;
+  pendingMutex.unlock();
+  // only one event per frame has to travel to the GUI thread
+  if (schedule)
+    QMetaObject::invokeMethod(this, "scheduleFrame", Qt::QueuedConnection);
+}
+
+// called when skipped parts of a Chunk were parsed, from worker threads
+void MapView::chunkPartsUpdated(int x, int z) {
+  Q_UNUSED(x);
+  Q_UNUSED(z);
+  pendingMutex.lock();
+  overlaysOutdated = true;
+  bool schedule = !frameScheduled;
+  frameScheduled = true;
+  pendingMutex.unlock();
+  if (schedule)
+    QMetaObject::invokeMethod(this, "scheduleFrame", Qt::QueuedConnection);
+}
+
+void MapView::scheduleFrame() {
+  if (!frameTimer.isActive())
+    frameTimer.start();
+}
+
+// draw all Chunks that were finished since the last frame in one batch
+void MapView::composeFrame() {
+  PerfScope scope(PerfCounters::stgCompose);
+  TraceScope trace("composite");
+
+  QSet<ChunkID> chunks;
+  pendingMutex.lock();
+  chunks.swap(pendingChunks);
+  bool overlays = overlaysOutdated;
+  overlaysOutdated = false;
+  frameScheduled = false;
+  pendingMutex.unlock();
+
+  QPainter canvas(&imageChunks);
+  if (this->zoom < 1.0)
+    canvas.setRenderHint(QPainter::SmoothPixmapTransform);
+  for (auto &id : chunks) {
+    drawChunk(canvas, id.getX(), id.getZ());
+    storeCoarse(id.getX(), id.getZ());
+  }
+  canvas.end();
+  if (overlays) {
+    int startx, startz, blockswide, blockstall;
+    getVisibleChunks(&startx, &startz, &blockswide, &blockstall);
+    drawOverlays(startx, startz, blockswide, blockstall);
+  }
   update();
 }
 
@@ -131,6 +218,14 @@ void MapView::clearCache() {
   redraw();
 }
 
+void MapView::updateDefinitions() {
+  // all renders based on the old definitions are outdated
+  // and Chunks have to classify their blocks again
+  renderCache.invalidate();
+  cache.clear();
+  redraw();
+}
+
 void MapView::adjustZoom(double steps)
 {
   const bool allowZoomOut = QSettings().value("zoomout", false).toBool();
@@ -151,6 +246,29 @@ void MapView::adjustZoom(double steps)
   if (zoom > zoomMax) zoom = zoomMax;
 }
 
+// collects the properties of overlay items in the I/O pool (Entities read
+// compressed Chunk data) and reports them to the view
+class PropertiesLoader : public QRunnable {
+ public:
+  PropertiesLoader(MapView *view, QList<QSharedPointer<OverlayItem>> items)
+    : view(view), items(items) {}
+
+ protected:
+  void run() {
+    QList<QVariant> properties;
+    for (auto &item : items)
+      properties.append(item->properties());
+    QVariant result(properties);
+    if (!properties.isEmpty())
+      QMetaObject::invokeMethod(view, "showProperties", Qt::QueuedConnection,
+                                Q_ARG(QVariant, result));
+  }
+
+ private:
+  MapView *view;
+  QList<QSharedPointer<OverlayItem>> items;
+};
+
 static int lastMouseX = -1, lastMouseY = -1;
 static bool dragging = false;
 void MapView::mousePressEvent(QMouseEvent *event) {
@@ -176,12 +294,15 @@ void MapView::mouseMoveEvent(QMouseEvent *event) {
     getToolTip(mx, mz);
     return;
   }
-  x += (lastMouseX-event->x()) / zoom;
-  z += (lastMouseY-event->y()) / zoom;
+  int dx = lastMouseX - event->x();
+  int dz = lastMouseY - event->y();
+  x += dx / zoom;
+  z += dz / zoom;
+  trackPan(dx / zoom, dz / zoom);
   lastMouseX = event->x();
   lastMouseY = event->y();
 
-  redraw();
+  scrollView(dx, dz);
 }
 
 void MapView::mouseReleaseEvent(QMouseEvent * /* event */) {
@@ -204,14 +325,10 @@ void MapView::mouseDoubleClickEvent(QMouseEvent *event) {
   // get the y coordinate
   int my = getY(mx, mz);
 
-  QList<QVariant> properties;
-  for (auto &item : getItems(mx, my, mz)) {
-    properties.append(item->properties());
-  }
-
-  if (!properties.isEmpty()) {
-    emit showProperties(properties);
-  }
+  QList<QSharedPointer<OverlayItem>> items = getItems(mx, my, mz);
+  if (!items.isEmpty())
+    WorkerPools::Instance().start(WorkerPools::stageIO,
+                                  new PropertiesLoader(this, items));
 }
 
 void MapView::wheelEvent(QWheelEvent *event) {
@@ -226,41 +343,45 @@ void MapView::wheelEvent(QWheelEvent *event) {
 
 void MapView::keyPressEvent(QKeyEvent *event) {
   // default: 16 blocks / 1 chunk
-  float stepSize = 16.0;
+  int stepSize = 16;
 
   if ((event->modifiers() & Qt::ShiftModifier) == Qt::ShiftModifier) {
     // 1 block for fine tuning
-    stepSize = 1.0;
+    stepSize = 1;
   }
   else if ((event->modifiers() & Qt::AltModifier) == Qt::AltModifier) {
     // 8 chunks
-    stepSize = 128.0;
+    stepSize = 128;
     if ((event->modifiers() & Qt::ControlModifier) == Qt::ControlModifier) {
       // 32 chunks / 1 Region
-      stepSize = 512.0;
+      stepSize = 512;
     }
   }
 
   switch (event->key()) {
     case Qt::Key_Up:
     case Qt::Key_W:
-      z -= stepSize / zoom;
-      redraw();
+      z -= double(stepSize) / zoom;
+      trackPan(0, -double(stepSize) / zoom);
+      scrollView(0, -stepSize);
       break;
     case Qt::Key_Down:
     case Qt::Key_S:
-      z += stepSize / zoom;
-      redraw();
+      z += double(stepSize) / zoom;
+      trackPan(0, double(stepSize) / zoom);
+      scrollView(0, stepSize);
       break;
     case Qt::Key_Left:
     case Qt::Key_A:
-      x -= stepSize / zoom;
-      redraw();
+      x -= double(stepSize) / zoom;
+      trackPan(-double(stepSize) / zoom, 0);
+      scrollView(-stepSize, 0);
       break;
     case Qt::Key_Right:
     case Qt::Key_D:
-      x += stepSize / zoom;
-      redraw();
+      x += double(stepSize) / zoom;
+      trackPan(double(stepSize) / zoom, 0);
+      scrollView(stepSize, 0);
       break;
     case Qt::Key_PageUp:
     case Qt::Key_Q:
@@ -288,16 +409,76 @@ void MapView::keyPressEvent(QKeyEvent *event) {
 void MapView::resizeEvent(QResizeEvent *event) {
   imageChunks   = QImage(event->size(), QImage::Format_RGB32);
   imageOverlays = QImage(event->size(), QImage::Format_RGBA8888);
+  imageOverlays.fill(0);
+  overlaysClear = true;
+  scrollX = 0;
+  scrollY = 0;
   redraw();
 }
 
 void MapView::paintEvent(QPaintEvent * /* event */) {
   QPainter p(this);
-  p.drawImage(QPoint(0, 0), imageChunks);
+  // unroll the ring buffer, it is split into up to four parts
+  int splitX = imageChunks.width()  - scrollX;
+  int splitY = imageChunks.height() - scrollY;
+  p.drawImage(QPoint(0, 0), imageChunks,
+              QRect(scrollX, scrollY, splitX, splitY));
+  if (scrollX > 0)
+    p.drawImage(QPoint(splitX, 0), imageChunks,
+                QRect(0, scrollY, scrollX, splitY));
+  if (scrollY > 0)
+    p.drawImage(QPoint(0, splitY), imageChunks,
+                QRect(scrollX, 0, splitX, scrollY));
+  if (scrollX > 0 && scrollY > 0)
+    p.drawImage(QPoint(splitX, splitY), imageChunks,
+                QRect(0, 0, scrollX, scrollY));
   p.drawImage(QPoint(0, 0), imageOverlays);
+  if (showPerformance)
+    drawPerformance(p);
   p.end();
 }
 
+void MapView::updateSettings() {
+  progressive = QSettings().value("progressive", true).toBool();
+  redraw();
+}
+
+void MapView::setPerformanceVisible(bool visible) {
+  showPerformance = visible;
+  if (visible) {
+    perfTimer.start();
+  } else {
+    perfTimer.stop();
+    PerfCounters::Instance().reset();
+  }
+  update();
+}
+
+// overlay with the timing counters of the pipeline
+void MapView::drawPerformance(QPainter &p) {
+  QStringList lines = PerfCounters::Instance().report();
+  lines << QString("cache    cost %1/%2")
+           .arg(cache.getCost()).arg(cache.getMaxCost());
+  WorkerPools &pools = WorkerPools::Instance();
+  lines << QString("threads  io %1 cpu %2")
+           .arg(pools.getThreadCount(WorkerPools::stageIO))
+           .arg(pools.getThreadCount(WorkerPools::stageCPU));
+
+  QFont font("Monospace");
+  font.setStyleHint(QFont::TypeWriter);
+  p.setFont(font);
+  QFontMetrics metrics(font);
+  int width = 0;
+  for (auto &line : lines)
+    width = qMax(width, metrics.width(line));
+  QRect box(4, 4, width + 8, lines.size() * metrics.height() + 8);
+  p.fillRect(box, QColor(0, 0, 0, 160));
+  p.setPen(Qt::white);
+  for (int i = 0; i < lines.size(); i++)
+    p.drawText(box.left() + 4, box.top() + 4 + metrics.ascent() +
+               i * metrics.height(), lines[i]);
+}
+
 void MapView::redraw() {
   if (!this->isEnabled()) {
     // blank
@@ -306,6 +487,81 @@ void MapView::redraw() {
     return;
   }
 
+  PerfScope scope(PerfCounters::stgRedraw);
+  TraceScope trace("redraw");
+  // Chunks loaded from now on are rendered right away with these settings
+  cache.setRenderSettings(depth, flags);
+
+  int startx, startz, blockswide, blockstall;
+  getVisibleChunks(&startx, &startz, &blockswide, &blockstall);
+
+  QPainter chunkCanvas(&imageChunks);
+  if (this->zoom < 1.0)
+    chunkCanvas.setRenderHint(QPainter::SmoothPixmapTransform);
+  for (int cz = startz; cz < startz + blockstall; cz++)
+    for (int cx = startx; cx < startx + blockswide; cx++)
+      drawChunk(chunkCanvas, cx, cz);
+  chunkCanvas.end();
+
+  finishRedraw(startx, startz, blockswide, blockstall);
+}
+
+int MapView::countPendingChunks() {
+  int startx, startz, blockswide, blockstall;
+  getVisibleChunks(&startx, &startz, &blockswide, &blockstall);
+  int generation = renderCache.getGeneration();
+  int pending = 0;
+  for (int cz = startz; cz < startz + blockstall; cz++)
+    for (int cx = startx; cx < startx + blockswide; cx++) {
+      QSharedPointer<Chunk> chunk(cache.fetchCached(cx, cz));
+      if (!chunk) {
+        if (!cache.isKnownEmpty(cx, cz))
+          pending++;
+      } else if (!chunk->loaded ||
+                 chunk->renderedAt != depth ||
+                 chunk->renderedFlags != flags ||
+                 chunk->renderedGeneration != generation) {
+        pending++;
+      }
+    }
+  return pending;
+}
+
+// move the view by the given amount of pixels
+// and draw only the newly exposed parts
+void MapView::scrollView(int dx, int dy) {
+  int width  = imageChunks.width();
+  int height = imageChunks.height();
+  if (!this->isEnabled() || qAbs(dx) >= width || qAbs(dy) >= height) {
+    redraw();
+    return;
+  }
+
+  // shift the origin of the ring buffer instead of moving pixels
+  scrollX = (scrollX + dx + width)  % width;
+  scrollY = (scrollY + dy + height) % height;
+
+  QPainter chunkCanvas(&imageChunks);
+  if (this->zoom < 1.0)
+    chunkCanvas.setRenderHint(QPainter::SmoothPixmapTransform);
+  if (dx > 0)
+    drawChunks(chunkCanvas, QRect(width - dx, 0, dx, height));
+  else if (dx < 0)
+    drawChunks(chunkCanvas, QRect(0, 0, -dx, height));
+  if (dy > 0)
+    drawChunks(chunkCanvas, QRect(0, height - dy, width, dy));
+  else if (dy < 0)
+    drawChunks(chunkCanvas, QRect(0, 0, width, -dy));
+  chunkCanvas.end();
+
+  int startx, startz, blockswide, blockstall;
+  getVisibleChunks(&startx, &startz, &blockswide, &blockstall);
+  finishRedraw(startx, startz, blockswide, blockstall);
+}
+
+// get the range of Chunks on screen (including a margin of one Chunk)
+void MapView::getVisibleChunks(int *startx, int *startz,
+                               int *blockswide, int *blockstall) const {
   double chunksize = 16 * zoom;
 
   // first find the center block position
@@ -318,18 +574,80 @@ void MapView::redraw() {
   centerx -= (x - centerchunkx * 16) * zoom;
   centery -= (z - centerchunkz * 16) * zoom;
   // now calculate the topleft block on the screen
-  int startx = centerchunkx - floor(centerx / chunksize) - 1;
-  int startz = centerchunkz - floor(centery / chunksize) - 1;
+  *startx = centerchunkx - floor(centerx / chunksize) - 1;
+  *startz = centerchunkz - floor(centery / chunksize) - 1;
   // and the dimensions of the screen in blocks
-  int blockswide = imageChunks.width() / chunksize + 3;
-  int blockstall = imageChunks.height() / chunksize + 3;
+  *blockswide = imageChunks.width() / chunksize + 3;
+  *blockstall = imageChunks.height() / chunksize + 3;
+}
 
-  for (int cz = startz; cz < startz + blockstall; cz++)
-    for (int cx = startx; cx < startx + blockswide; cx++)
-      drawChunk(cx, cz);
+// draw all Chunks that cover the given part of the screen
+void MapView::drawChunks(QPainter &canvas, const QRect &area) {
+  int centerx = imageChunks.width() / 2;
+  int centery = imageChunks.height() / 2;
+  // block coordinates of the area corners
+  int startx = floor((x + (area.left()  - centerx) / zoom) / 16);
+  int startz = floor((z + (area.top()   - centery) / zoom) / 16);
+  int endx   = floor((x + (area.right()  + 1 - centerx) / zoom) / 16);
+  int endz   = floor((z + (area.bottom() + 1 - centery) / zoom) / 16);
+  for (int cz = startz; cz <= endz; cz++)
+    for (int cx = startx; cx <= endx; cx++)
+      drawChunk(canvas, cx, cz);
+}
+
+// draw a Chunk image at its screen position into the ring buffer
+void MapView::drawWrapped(QPainter &canvas, const QRectF &target,
+                          const QImage &image) {
+  int width  = imageChunks.width();
+  int height = imageChunks.height();
+  int splitX = width  - scrollX;
+  int splitY = height - scrollY;
+  // parts of the screen and their offset inside the ring buffer
+  const QRect parts[4] = {
+    QRect(0,      0,      splitX,  splitY),
+    QRect(splitX, 0,      scrollX, splitY),
+    QRect(0,      splitY, splitX,  scrollY),
+    QRect(splitX, splitY, scrollX, scrollY)
+  };
+  const QPoint offsets[4] = {
+    QPoint(scrollX,         scrollY),
+    QPoint(scrollX - width, scrollY),
+    QPoint(scrollX,         scrollY - height),
+    QPoint(scrollX - width, scrollY - height)
+  };
+  for (int i = 0; i < 4; i++) {
+    if (parts[i].isEmpty() || !target.intersects(parts[i]))
+      continue;
+    if (QRectF(parts[i]).contains(target)) {
+      canvas.drawImage(target.translated(offsets[i]), image);
+    } else {
+      // never draw across the wrap around of the buffer
+      canvas.setClipRect(parts[i].translated(offsets[i]));
+      canvas.drawImage(target.translated(offsets[i]), image);
+      canvas.setClipping(false);
+    }
+  }
+}
+
+// everything besides the Chunk layer
+void MapView::finishRedraw(int startx, int startz,
+                           int blockswide, int blockstall) {
+  prefetchAhead(startx, startz, blockswide, blockstall);
+  drawOverlays(startx, startz, blockswide, blockstall);
+  emit(coordinatesChanged(x, depth, z));
+  update();
+}
+
+// Entities and generated structures on top of the Chunks
+void MapView::drawOverlays(int startx, int startz,
+                           int blockswide, int blockstall) {
+  // nothing to do when no overlay is visible (and already cleared)
+  if (overlayItemTypes.isEmpty() && overlaysClear)
+    return;
 
   // clear the overlay layer
   imageOverlays.fill(0);
+  overlaysClear = overlayItemTypes.isEmpty();
 
   // add on the entity layer
   QPainter canvas(&imageOverlays);
@@ -344,65 +662,95 @@ void MapView::redraw() {
   for (int cz = startz; cz < startz + blockstall; cz++) {
     for (int cx = startx; cx < startx + blockswide; cx++) {
       QSharedPointer<Chunk> chunk(cache.fetch(cx, cz));
-      if (chunk) {
+      // Entities are parsed in the background when an overlay needs them
+      if (chunk && chunk->loaded &&
+          !(chunk->missingParts() & Chunk::partEntities)) {
         // Entities from Chunks
-        for (auto &type : overlayItemTypes) {
-          auto range = chunk->entities.equal_range(type);
-          for (auto it = range.first; it != range.second; ++it) {
-            // don't show entities above our depth
-            int entityY = (*it)->midpoint().y;
-            // everything below the current block,
-            // but also inside the current block
-            if (entityY < depth + 1) {
-              int entityX = static_cast<int>((*it)->midpoint().x) & 0x0f;
-              int entityZ = static_cast<int>((*it)->midpoint().z) & 0x0f;
-              int index = entityX + (entityZ << 4);
-              int highY = chunk->depth[index];
-              if ( (entityY+10 >= highY) ||
-                   (entityY+10 >= depth) )
-                (*it)->draw(x1, z1, zoom, &canvas);
-            }
+        for (auto &entity : chunk->entities) {
+          // don't show entities above our depth
+          int entityY = entity.y;
+          // everything below the current block,
+          // but also inside the current block
+          if (entityY < depth + 1 &&
+              overlayItemTypes.contains(Entity::getKind(entity.kind).type)) {
+            int entityX = static_cast<int>(entity.x) & 0x0f;
+            int entityZ = static_cast<int>(entity.z) & 0x0f;
+            int index = entityX + (entityZ << 4);
+            int highY = chunk->depth[index];
+            if ( (entityY+10 >= highY) ||
+                 (entityY+10 >= depth) )
+              Entity::draw(entity, x1, z1, zoom, &canvas);
           }
         }
-
       }
     }
   }
 
   // draw the generated structures
   for (auto &type : overlayItemTypes) {
-    for (auto &item : overlayItems[type]) {
-      if (item->intersects(OverlayItem::Point(x1 - 1, 0, z1 - 1),
-                           OverlayItem::Point(x2 + 1, depth, z2 + 1))) {
-        item->draw(x1, z1, zoom, &canvas);
-      }
-    }
+    auto index = overlayItems.constFind(type);
+    if (index == overlayItems.constEnd())
+      continue;
+    for (auto &item : index->query(OverlayItem::Point(x1 - 1, 0, z1 - 1),
+                                   OverlayItem::Point(x2 + 1, depth, z2 + 1)))
+      item->draw(x1, z1, zoom, &canvas);
   }
+}
 
-  emit(coordinatesChanged(x, depth, z));
+// estimate where panning will go to during the next moments
+void MapView::trackPan(double dx, double dz) {
+  qint64 elapsed = panTimer.isValid() ? panTimer.restart() : PREFETCH_IDLE_MS;
+  if (!panTimer.isValid())
+    panTimer.start();
+  if (elapsed >= PREFETCH_IDLE_MS) {
+    // start of a new movement: nothing known about speed yet
+    panAheadX = dx;
+    panAheadZ = dz;
+    return;
+  }
+  // extrapolate current speed, but look at least one step ahead
+  // (keyboard panning moves in big discrete steps)
+  double scale = double(PREFETCH_LOOKAHEAD_MS) / qMax<qint64>(elapsed, 1);
+  double aheadX = (fabs(dx * scale) > fabs(dx)) ? dx * scale : dx;
+  double aheadZ = (fabs(dz * scale) > fabs(dz)) ? dz * scale : dz;
+  // smooth jitter of mouse movement
+  panAheadX = 0.5 * panAheadX + 0.5 * aheadX;
+  panAheadZ = 0.5 * panAheadZ + 0.5 * aheadZ;
+}
 
-  update();
+// queue loading of Chunks that will become visible when panning continues
+void MapView::prefetchAhead(int startx, int startz, int wide, int tall) {
+  if (!panTimer.isValid() || panTimer.elapsed() >= PREFETCH_IDLE_MS)
+    return;  // not moving
+
+  int aheadX = qMin(int(ceil(fabs(panAheadX) / 16)), PREFETCH_MAX_CHUNKS);
+  int aheadZ = qMin(int(ceil(fabs(panAheadZ) / 16)), PREFETCH_MAX_CHUNKS);
+  int dirX = (panAheadX < 0) ? -1 : 1;
+  int dirZ = (panAheadZ < 0) ? -1 : 1;
+
+  // only the leading edges are new: walk them from near to far
+  for (int d = 1; d <= qMax(aheadX, aheadZ); d++) {
+    if (d <= aheadX) {
+      int cx = (dirX > 0) ? startx + wide - 1 + d : startx - d;
+      for (int cz = startz; cz < startz + tall; cz++)
+        cache.prefetch(cx, cz);
+    }
+    if (d <= aheadZ) {
+      int cz = (dirZ > 0) ? startz + tall - 1 + d : startz - d;
+      for (int cx = startx; cx < startx + wide; cx++)
+        cache.prefetch(cx, cz);
+    }
+  }
 }
 
-void MapView::drawChunk(int x, int z) {
+void MapView::drawChunk(QPainter &canvas, int x, int z) {
   if (!this->isEnabled())
     return;
 
-  uchar *src = placeholder;
   // fetch the chunk
   QSharedPointer<Chunk> chunk(cache.fetch(x, z));
   if (chunk && !chunk->loaded) return;
 
-  if (chunk && (chunk->renderedAt != depth ||
-                chunk->renderedFlags != flags)) {
-    //renderChunk(chunk);
-    ChunkRenderer *renderer = new ChunkRenderer(x, z, depth, flags);
-    connect(renderer, SIGNAL(rendered(int, int)),
-            this,     SLOT(chunkUpdated(int, int)));
-    QThreadPool::globalInstance()->start(renderer);
-    return;
-  }
-
   // this figures out where on the screen this chunk should be drawn
 
   // first find the center chunk
@@ -420,15 +768,112 @@ void MapView::drawChunk(int x, int z) {
   centerx += (x - centerchunkx) * chunksize;
   centery += (z - centerchunkz) * chunksize;
 
+  QRectF targetRect(centerx, centery, chunksize, chunksize);
+
   const uchar* srcImageData = chunk ? chunk->image : placeholder;
+  uchar coarse[16 * 16 * 4];
+
+  // Chunks outside the screen (prefetched) are rendered with low priority
+  int priority = targetRect.intersects(imageChunks.rect()) ? 0 : -1;
+  // a running render job reports again when it is finished
+  bool pending = chunk && chunk->rendering.loadAcquire();
+  if (chunk && !pending && !isRendered(*chunk) &&
+      !renderCache.restore(chunk.data(), depth, flags)) {
+    startRenderer(chunk, priority);
+    pending = true;
+  } else if (chunk && !pending && isWestEdgeOutdated(*chunk)) {
+    // the western neighbour is rendered by now, shade the edge using it
+    startRenderer(chunk, priority);
+  }
+
+  if (pending && !isRendered(*chunk)) {
+    if (!progressive)
+      return;
+    // show an approximation until the final image is rendered:
+    // an outdated render is still better than just Biome colors
+    if (chunk->renderedAt == -1) {
+      renderCoarse(*chunk, coarse);
+      srcImageData = coarse;
+    }
+  } else if (!chunk && progressive) {
+    // Chunk is not loaded yet, use the color of a previous visit
+    const QRgb *tile = coarseTiles.object(coarseKey(x, z));
+    if (tile) {
+      quint32 *pixels = reinterpret_cast<quint32 *>(coarse);
+      for (int i = 0; i < 16 * 16; i++)
+        pixels[i] = *tile;
+      srcImageData = coarse;
+    }
+  }
+
   QImage srcImage(srcImageData, 16, 16, QImage::Format_RGB32);
+  drawWrapped(canvas, targetRect, srcImage);
+}
 
-  QRectF targetRect(centerx, centery, chunksize, chunksize);
+void MapView::startRenderer(QSharedPointer<Chunk> chunk, int priority) {
+  chunk->rendering.store(1);
+  ChunkRenderer *renderer = new ChunkRenderer(chunk, depth, flags);
+  connect(renderer, SIGNAL(rendered(int, int)),
+          this,     SLOT(chunkUpdated(int, int)), Qt::DirectConnection);
+  WorkerPools::Instance().start(WorkerPools::stageCPU, renderer, priority);
+}
 
-  QPainter canvas(&imageChunks);
-  if (this->zoom < 1.0)
-      canvas.setRenderHint(QPainter::SmoothPixmapTransform);
-  canvas.drawImage(targetRect, srcImage);
+// Chunk is rendered with the current view settings
+bool MapView::isRendered(const Chunk &chunk) const {
+  return chunk.renderedAt == depth &&
+         chunk.renderedFlags == flags &&
+         chunk.renderedGeneration == renderCache.getGeneration();
+}
+
+// the western neighbour is rendered with other heights than the Chunk's
+// edge was shaded with
+bool MapView::isWestEdgeOutdated(const Chunk &chunk) {
+  QSharedPointer<Chunk> west(cache.fetchCached(chunk.chunkX - 1,
+                                               chunk.chunkZ));
+  int heights[16];
+  if (!west || !west->readEastEdge(depth, flags, renderCache.getGeneration(),
+                                   heights))
+    return false;
+  for (int z = 0; z < 16; z++)
+    if (chunk.westEdge[z] != heights[z])
+      return true;
+  return false;
+}
+
+// cheap approximation of a Chunk based on Biome data only
+void MapView::renderCoarse(const Chunk &chunk, uchar *bits) const {
+  BiomeIdentifier &bi = BiomeIdentifier::Instance();
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    const QColor &color = bi.getBiome(chunk.biomes[offset]).colors[13];
+    *bits++ = color.blue();
+    *bits++ = color.green();
+    *bits++ = color.red();
+    *bits++ = 0xff;
+  }
+}
+
+// remember the average color of a finished Chunk
+void MapView::storeCoarse(int x, int z) {
+  QSharedPointer<Chunk> chunk(cache.fetchCached(x, z));
+  if (!chunk || !chunk->loaded || chunk->renderedAt == -1)
+    return;
+  int r = 0, g = 0, b = 0;
+  const uchar *bits = chunk->image;
+  for (int i = 0; i < 16 * 16; i++) {
+    b += *bits++;
+    g += *bits++;
+    r += *bits++;
+    bits++;
+  }
+  coarseTiles.insert(coarseKey(x, z),
+                     new QRgb(qRgb(r / 256, g / 256, b / 256)));
+}
+
+// dimension in the upper bits, 24 bits are plenty for Chunk coordinates
+quint64 MapView::coarseKey(int x, int z) const {
+  return (quint64(coarseDimension) << 48) |
+         (quint64(x & 0xffffff) << 24) |
+         quint64(z & 0xffffff);
 }
 
 void MapView::getToolTip(int x, int z) {
@@ -442,8 +887,11 @@ void MapView::getToolTip(int x, int z) {
   QString biome = "Unknown Biome";
   QString blockstate;
   QMap<QString, int> entityIds;
+  int spawnable = -1;
 
   if (chunk) {
+    if (flags & flgMobSpawn)
+      spawnable = MobSpawn::countSpawnable(*chunk, depth);
     int top = qMin(depth, chunk->highest);
     for (y = top; y >= 0; y--) {
       int sec = y >> 4;
@@ -500,12 +948,8 @@ void MapView::getToolTip(int x, int z) {
     hovertext += " (" + blockstate + ")";
   if (entityStr.length() > 0)
     hovertext += " - " + entityStr;
-
-#ifdef DEBUG
-  hovertext += " [Cache:"
-            + QString().number(this->cache.getCost()) + "/"
-            + QString().number(this->cache.getMaxCost()) + "]";
-#endif
+  if (spawnable >= 0)
+    hovertext += QString(" - Spawnable in Chunk: %1").arg(spawnable);
 
   emit hoverTextChanged(hovertext);
 }
@@ -518,15 +962,8 @@ void MapView::addStructureFromChunk(QSharedPointer<GeneratedStructure> structure
 }
 
 void MapView::addOverlayItem(QSharedPointer<OverlayItem> item) {
-  // test if item is already in list
-  for (auto &it: overlayItems[item->type()]) {
-    OverlayItem::Point p1 = it  ->midpoint();
-    OverlayItem::Point p2 = item->midpoint();
-    if ( (p1.x == p2.x) && (p1.y == p2.y) && (p1.z == p2.z) )
-      return;  // skip if already present
-  }
-  // otherwise add item
-  overlayItems[item->type()].push_back(item);
+  // add item (skipped by the index if already present)
+  overlayItems[item->type()].insert(item);
 }
 
 void MapView::clearOverlayItems() {
@@ -535,6 +972,16 @@ void MapView::clearOverlayItems() {
 
 void MapView::setVisibleOverlayItemTypes(const QSet<QString>& itemTypes) {
   overlayItemTypes = itemTypes;
+
+  // only parse what the visible overlays need
+  int parts = 0;
+  for (auto &type : itemTypes) {
+    if (type.startsWith("Entity."))
+      parts |= Chunk::partEntities;
+    else
+      parts |= Chunk::partStructures;
+  }
+  cache.setOverlayDemand(parts);
 }
 
 int MapView::getY(int x, int z) {
@@ -554,26 +1001,26 @@ QList<QSharedPointer<OverlayItem>> MapView::getItems(int x, int y, int z) {
     double invzoom = 10.0 / zoom;
     for (auto &type : overlayItemTypes) {
       // generated structures
-      for (auto &item : overlayItems[type]) {
+      auto index = overlayItems.constFind(type);
+      if (index != overlayItems.constEnd()) {
         double ymin = 0;
         double ymax = depth;
-        if (item->intersects(OverlayItem::Point(x, ymin, z),
-                             OverlayItem::Point(x, ymax, z))) {
-          ret.append(item);
-        }
+        ret.append(index->query(OverlayItem::Point(x, ymin, z),
+                                OverlayItem::Point(x, ymax, z)));
       }
 
-      // entities
-      auto itemRange = chunk->entities.equal_range(type);
-      for (auto itItem = itemRange.first; itItem != itemRange.second;
-          ++itItem) {
+      // entities (available once parsed in the background)
+      if (chunk->missingParts() & Chunk::partEntities)
+        continue;
+      for (auto &entity : chunk->entities) {
         double ymin = y - 4;
         double ymax = depth + 4;
 
-        if ((*itItem)->intersects(
-            OverlayItem::Point(x - invzoom/2, ymin, z - invzoom/2),
-            OverlayItem::Point(x + 1 + invzoom/2, ymax, z + 1 + invzoom/2))) {
-          ret.append(*itItem);
+        if (entity.x >= x - invzoom/2 && entity.x <= x + 1 + invzoom/2 &&
+            entity.y >= ymin          && entity.y <= ymax &&
+            entity.z >= z - invzoom/2 && entity.z <= z + 1 + invzoom/2 &&
+            Entity::getKind(entity.kind).type == type) {
+          ret.append(Entity::fromRecord(entity, cx, cz));
         }
       }
     }
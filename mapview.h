@@ -4,11 +4,18 @@
 
 #include <QtWidgets/QWidget>
 #include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QMutex>
+#include <QCache>
 #include "./chunkcache.h"
+#include "./overlayindex.h"
 class DefinitionManager;
 class BiomeIdentifier;
 class BlockIdentifier;
 class OverlayItem;
+class RenderCache;
+class QPainter;
 
 class MapView : public QWidget {
   Q_OBJECT
@@ -47,6 +54,8 @@ class MapView : public QWidget {
   void addOverlayItem(QSharedPointer<OverlayItem> item);
   void clearOverlayItems();
   void setVisibleOverlayItemTypes(const QSet<QString>& itemTypes);
+  // visible Chunks not yet loaded or rendered with the current settings
+  int countPendingChunks();
 
   // public for saving the png
   QString getWorldPath();
@@ -55,11 +64,18 @@ class MapView : public QWidget {
  public slots:
   void setDepth(int depth);
   void chunkUpdated(int x, int z);
+  void chunkPartsUpdated(int x, int z);
   void redraw();
 
   // Clears the cache and redraws, causing all chunks to be re-loaded;
   // but keeps the viewport
   void clearCache();
+  // forget all renders that are based on outdated definitions
+  void updateDefinitions();
+  // overlay with performance counters of the loading pipeline
+  void setPerformanceVisible(bool visible);
+  // pick up changed options from the settings dialog
+  void updateSettings();
 
  signals:
   void hoverTextChanged(QString text);
@@ -81,29 +97,77 @@ class MapView : public QWidget {
 
  private slots:
   void addStructureFromChunk(QSharedPointer<GeneratedStructure> structure);
+  void scheduleFrame();
+  void composeFrame();
 
  private:
-  void drawChunk(int x, int z);
+  void drawChunk(QPainter &canvas, int x, int z);
+  void startRenderer(QSharedPointer<Chunk> chunk, int priority);
+  bool isRendered(const Chunk &chunk) const;
+  bool isWestEdgeOutdated(const Chunk &chunk);
+  void drawChunks(QPainter &canvas, const QRect &area);
+  void drawWrapped(QPainter &canvas, const QRectF &target, const QImage &image);
+  void getVisibleChunks(int *startx, int *startz,
+                        int *blockswide, int *blockstall) const;
+  void scrollView(int dx, int dy);
+  void finishRedraw(int startx, int startz, int blockswide, int blockstall);
+  void drawOverlays(int startx, int startz, int blockswide, int blockstall);
+  void drawPerformance(QPainter &p);
+  void renderCoarse(const Chunk &chunk, uchar *bits) const;
+  void storeCoarse(int x, int z);
+  quint64 coarseKey(int x, int z) const;
   void getToolTip(int x, int z);
   int getY(int x, int z);
   QList<QSharedPointer<OverlayItem>> getItems(int x, int y, int z);
   void adjustZoom(double steps);
+  void trackPan(double dx, double dz);
+  void prefetchAhead(int startx, int startz, int wide, int tall);
 
   static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
   float caveshade[CAVE_DEPTH];
 
+  // prefetching of Chunks ahead of panning movement
+  static const int PREFETCH_LOOKAHEAD_MS = 500;  // predict movement that far
+  static const int PREFETCH_IDLE_MS = 500;       // stop prediction after idle
+  static const int PREFETCH_MAX_CHUNKS = 32;     // limit look ahead to a Region
+  QElapsedTimer panTimer;
+  double panAheadX, panAheadZ;  // predicted movement in blocks
+
+  // finished Chunks are collected and drawn once per frame
+  static const int FRAME_INTERVAL_MS = 16;
+  QTimer frameTimer;
+  QMutex pendingMutex;          // guards the pending state below
+  QSet<ChunkID> pendingChunks;  // filled from worker threads
+  bool overlaysOutdated;        // Chunk parts for overlays were parsed
+  bool frameScheduled;
+
+  // performance overlay, refreshed periodically while visible
+  static const int PERF_HUD_INTERVAL_MS = 500;
+  QTimer perfTimer;
+  bool showPerformance;
+
+  // one color per Chunk of every visited dimension, least recent dropped first
+  static const int COARSE_TILES_MAX = 1 << 18;
+  QCache<quint64, QRgb> coarseTiles;
+  QHash<QString, int> coarseDimensions;  // key prefix of each dimension
+  int coarseDimension;
+
   int depth;
   double x, z;
   int scale;
   double zoom;
   int flags;
   ChunkCache &cache;
-  QImage imageChunks;
+  RenderCache &renderCache;
+  QImage imageChunks;    // ring buffer, origin at (scrollX, scrollY)
   QImage imageOverlays;
+  int scrollX, scrollY;
+  bool overlaysClear;    // overlay layer contains nothing
   DefinitionManager *dm;
   uchar placeholder[16 * 16 * 4];  // no chunk found placeholder
+  bool progressive;                // show approximations until rendered
   QSet<QString> overlayItemTypes;
-  QMap<QString, QList<QSharedPointer<OverlayItem>>> overlayItems;
+  QMap<QString, OverlayIndex> overlayItems;
   BlockLocation currentLocation;
 };
 
@@ -44,6 +44,8 @@ Minutor::Minutor() {
   settings = new Settings(this);
   connect(settings, SIGNAL(settingsUpdated()),
           this, SLOT(rescanWorlds()));
+  connect(settings, SIGNAL(settingsUpdated()),
+          mapview, SLOT(updateSettings()));
   jumpTo = new JumpTo(this);
 
   if (settings->autoUpdate) {
@@ -425,6 +427,13 @@ void Minutor::createActions() {
   connect(refreshAct, SIGNAL(triggered()),
           mapview,    SLOT(clearCache()));
 
+  performanceAct = new QAction(tr("&Performance Overlay"), this);
+  performanceAct->setCheckable(true);
+  performanceAct->setShortcut(tr("Ctrl+Shift+P"));
+  performanceAct->setStatusTip(tr("Show timing of loading and rendering"));
+  connect(performanceAct, SIGNAL(toggled(bool)),
+          mapview,        SLOT(setPerformanceVisible(bool)));
+
   // [Help]
   aboutAct = new QAction(tr("&About"), this);
   aboutAct->setStatusTip(tr("About %1").arg(qApp->applicationName()));
@@ -537,6 +546,7 @@ void Minutor::createMenus() {
 
   viewMenu->addSeparator();
   viewMenu->addAction(refreshAct);
+  viewMenu->addAction(performanceAct);
   viewMenu->addSeparator();
   viewMenu->addAction(manageDefsAct);
 
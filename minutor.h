@@ -105,6 +105,7 @@ private slots:
   QAction *lightingAct, *mobSpawnAct, *caveModeAct, *depthShadingAct, *biomeColorsAct, *singleLayerAct;
   QAction *manageDefsAct;
   QAction *refreshAct;
+  QAction *performanceAct;
   QAction *aboutAct;
   QAction *settingsAct;
   QAction *updatesAct;
@@ -6,6 +6,13 @@ CONFIG += c++14
 QT += widgets network
 QMAKE_INFO_PLIST = minutor.plist
 unix:LIBS += -lz
+
+# asynchronous Region file reads on Linux
+unix:!macx:packagesExist(liburing) {
+  CONFIG += link_pkgconfig
+  PKGCONFIG += liburing
+  DEFINES += HAVE_LIBURING
+}
 win32:RC_FILE += winicon.rc
 macx:ICON=icon.icns
 
@@ -26,21 +33,31 @@ HEADERS += \
     chunkcache.h \
     chunkloader.h \
     chunkrenderer.h \
+    definitioncache.h \
     definitionmanager.h \
     definitionupdater.h \
     dimensionidentifier.h \
     entity.h \
     entityidentifier.h \
     generatedstructure.h \
+    interactionreplay.h \
     json.h \
     mapview.h \
+    mobspawn.h \
     minutor.h \
     nbt.h \
     overlayitem.h \
+    overlayindex.h \
+    perfcounters.h \
     properties.h \
+    regionreader.h \
+    rendercache.h \
     settings.h \
+    tracerecorder.h \
+    uringregionreader.h \
     village.h \
     worldsave.h \
+    workerpools.h \
     zipreader.h \
     clamp.h \
     jumpto.h \
@@ -55,21 +72,31 @@ SOURCES += \
     chunkcache.cpp \
     chunkloader.cpp \
     chunkrenderer.cpp \
+    definitioncache.cpp \
     definitionmanager.cpp \
     definitionupdater.cpp \
     dimensionidentifier.cpp \
     entity.cpp \
     entityidentifier.cpp \
     generatedstructure.cpp \
+    interactionreplay.cpp \
     json.cpp \
     main.cpp \
     mapview.cpp \
+    mobspawn.cpp \
     minutor.cpp \
     nbt.cpp \
+    overlayindex.cpp \
+    perfcounters.cpp \
     properties.cpp \
+    regionreader.cpp \
+    rendercache.cpp \
     settings.cpp \
+    tracerecorder.cpp \
+    uringregionreader.cpp \
     village.cpp \
     worldsave.cpp \
+    workerpools.cpp \
     zipreader.cpp \
     jumpto.cpp \
     pngexport.cpp \
@@ -99,6 +126,21 @@ pixmapfile.files = minutor.png minutor.xpm
 target.path = /usr/bin
 INSTALLS += desktopfile pixmapfile target
 
+# "make bench" builds and runs the benchmarks in bench/
+BENCH_DIR = $$shell_path($$OUT_PWD/bench)
+win32 {
+  BENCH_CD = cd /d
+  BENCH_EXE = bench.exe
+} else {
+  BENCH_CD = cd
+  BENCH_EXE = ./bench
+}
+bench.commands = $$sprintf($$QMAKE_MKDIR_CMD, $$BENCH_DIR) && \
+    $$BENCH_CD $$BENCH_DIR && \
+    $$QMAKE_QMAKE $$shell_path($$PWD/bench/bench.pro) && $(MAKE) && \
+    $$BENCH_EXE -o results.xml,xml -o results.csv,csv -o -,txt
+QMAKE_EXTRA_TARGETS += bench
+
 FORMS += \
     properties.ui \
     settings.ui \
@@ -0,0 +1,97 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include "./mobspawn.h"
+#include "./chunk.h"
+#include "./blockidentifier.h"
+
+// collect the section masks of one property into a whole column
+// missing sections are filled with the property of air
+MobSpawn::Column MobSpawn::getColumn(const Chunk &chunk, int offset,
+                                     Property prop, bool fill) {
+  Column c = {{0, 0, 0, 0}};
+  for (int sec = 0; sec < 16; sec++) {
+    const ChunkSection *section = chunk.sections[sec];
+    quint64 mask = 0xffff;
+    if (section) {
+      switch (prop) {
+        case propSolidTop:    mask = section->solidTop[offset];    break;
+        case propNormalCube:  mask = section->normalCube[offset];  break;
+        case propSpawnInside: mask = section->spawnInside[offset]; break;
+        case propLiquid:      mask = section->liquid[offset];      break;
+        case propBedrock:     mask = section->bedrock[offset];     break;
+        case propDark:        mask = section->dark[offset];        break;
+        default:              mask = 0;
+      }
+    } else if (!fill) {
+      mask = 0;
+    }
+    c.bits[sec >> 2] |= mask << ((sec & 3) * 16);
+  }
+  return c;
+}
+
+// move every bit n to n-shift, heights above the world are filled
+MobSpawn::Column MobSpawn::shiftDown(const Column &c, int n, bool fill) {
+  Column r;
+  quint64 above = fill ? ~quint64(0) : 0;
+  for (int i = 0; i < 4; i++) {
+    quint64 next = (i < 3) ? c.bits[i + 1] : above;
+    r.bits[i] = (c.bits[i] >> n) | (next << (64 - n));
+  }
+  return r;
+}
+
+MobSpawn::Column MobSpawn::spawnable(const Chunk &chunk, int offset) {
+  // properties of air are used for missing sections and above the world
+  BlockInfo &air = BlockIdentifier::Instance().getBlockInfo(0);
+  bool airSolidTop    = air.doesBlockHaveSolidTopSurface();
+  bool airNormalCube  = air.isBlockNormalCube();
+  bool airSpawnInside = air.spawninside;
+  bool airLiquid      = air.isLiquid();
+  bool airBedrock     = air.isBedrock();
+
+  Column solidTop    = getColumn(chunk, offset, propSolidTop,    airSolidTop);
+  Column normalCube  = getColumn(chunk, offset, propNormalCube,  airNormalCube);
+  Column spawnInside = getColumn(chunk, offset, propSpawnInside, airSpawnInside);
+  Column liquid      = getColumn(chunk, offset, propLiquid,      airLiquid);
+  Column bedrock     = getColumn(chunk, offset, propBedrock,     airBedrock);
+  Column dark        = getColumn(chunk, offset, propDark,        true);
+
+  // the block itself has to carry the mob,
+  // the one above has to be dark and free of liquid,
+  // and both blocks above have to leave room for the mob
+  Column ground, space, room;
+  for (int i = 0; i < 4; i++) {
+    ground.bits[i] = solidTop.bits[i] & ~bedrock.bits[i];
+    room.bits[i]  = ~normalCube.bits[i] & spawnInside.bits[i];
+    space.bits[i] = room.bits[i] & ~liquid.bits[i] & dark.bits[i];
+  }
+  bool airRoom  = !airNormalCube && airSpawnInside;
+  bool airSpace = airRoom && !airLiquid;
+  Column space1 = shiftDown(space, 1, airSpace);
+  Column room2  = shiftDown(room,  2, airRoom);
+
+  Column result;
+  for (int i = 0; i < 4; i++)
+    result.bits[i] = ground.bits[i] & space1.bits[i] & room2.bits[i];
+  return result;
+}
+
+int MobSpawn::countSpawnable(const Chunk &chunk, int maxY) {
+  if (!chunk.loaded || maxY < 0)
+    return 0;
+  maxY = qMin(maxY, 255);
+  int count = 0;
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    Column c = spawnable(chunk, offset);
+    for (int i = 0; i < 4; i++) {
+      quint64 bits = c.bits[i];
+      int below = maxY + 1 - i * 64;  // heights of this word to count
+      if (below <= 0)
+        break;
+      if (below < 64)
+        bits &= (quint64(1) << below) - 1;
+      count += qPopulationCount(bits);
+    }
+  }
+  return count;
+}
@@ -0,0 +1,36 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef MOBSPAWN_H_
+#define MOBSPAWN_H_
+
+#include <QtGlobal>
+
+class Chunk;
+
+// evaluates mob spawning conditions with bit masks for complete columns
+class MobSpawn {
+ public:
+  // one bit per height of a column (bit n of word n/64 is height n)
+  struct Column {
+    quint64 bits[4];
+    bool test(int y) const {
+      return (y >= 0) && (y < 256) && ((bits[y >> 6] >> (y & 63)) & 1);
+    }
+  };
+
+  // heights of blocks a mob can spawn on top of
+  static Column spawnable(const Chunk &chunk, int offset);
+
+  // number of blocks in the Chunk (at or below maxY) a mob can spawn on
+  static int countSpawnable(const Chunk &chunk, int maxY = 255);
+
+ private:
+  enum Property {
+    propSolidTop, propNormalCube, propSpawnInside,
+    propLiquid, propBedrock, propDark, propCount
+  };
+  static Column getColumn(const Chunk &chunk, int offset, Property prop,
+                          bool fill);
+  static Column shiftDown(const Column &c, int n, bool fill);
+};
+
+#endif  // MOBSPAWN_H_
@@ -5,6 +5,7 @@
 #include <QStringList>
 
 #include "./nbt.h"
+#include "./perfcounters.h"
 #include "zlib/zlib.h"
 
 // this handles decoding the gzipped level.dat
@@ -64,15 +65,19 @@ NBT::NBT(const uchar *chunk) {
 
   QByteArray nbt;
 
-  inflateInit(&strm);
-  do {
-    strm.avail_out = CHUNK_SIZE;
-    strm.next_out = reinterpret_cast<Bytef *>(out);
-    inflate(&strm, Z_NO_FLUSH);
-    nbt.append(out, CHUNK_SIZE - strm.avail_out);
-  } while (strm.avail_out == 0);
-  inflateEnd(&strm);
+  {
+    PerfScope scope(PerfCounters::stgInflate);
+    inflateInit(&strm);
+    do {
+      strm.avail_out = CHUNK_SIZE;
+      strm.next_out = reinterpret_cast<Bytef *>(out);
+      inflate(&strm, Z_NO_FLUSH);
+      nbt.append(out, CHUNK_SIZE - strm.avail_out);
+    } while (strm.avail_out == 0);
+    inflateEnd(&strm);
+  }
 
+  PerfScope scope(PerfCounters::stgParse);
   TagDataStream s(nbt.constData(), nbt.size());
 
   if (s.r8() == 10) {  // compound
@@ -412,6 +417,9 @@ const Tag *Tag_Compound::at(const QString key) const {
     return &NBT::Null;
   return children[key];
 }
+const QList<QString> Tag_Compound::keys() const {
+  return children.keys();
+}
 
 const QString Tag_Compound::toString() const {
   QStringList ret;
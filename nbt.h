@@ -161,6 +161,7 @@ class Tag_Compound : public Tag {
   ~Tag_Compound();
   bool has(const QString key) const;
   const Tag *at(const QString key) const;
+  const QList<QString> keys() const;
   virtual const QString toString() const;
   virtual const QVariant getData() const;
  private:
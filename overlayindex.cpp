@@ -0,0 +1,74 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include <QSet>
+#include "./overlayindex.h"
+
+bool OverlayIndex::insert(QSharedPointer<OverlayItem> item) {
+  OverlayItem::Point mid = item->midpoint();
+  // an identical item would be referenced from the cell of the midpoint
+  if (contains(cells.value(CellID(cell(mid.x), cell(mid.z))), mid) ||
+      contains(large, mid))
+    return false;
+
+  OverlayItem::Point min, max;
+  item->bounds(&min, &max);
+  int x1 = cell(min.x), x2 = cell(max.x);
+  int z1 = cell(min.z), z2 = cell(max.z);
+  if ((x2 - x1 + 1) * (z2 - z1 + 1) > MAX_CELLS) {
+    large.append(item);
+  } else {
+    for (int cz = z1; cz <= z2; cz++)
+      for (int cx = x1; cx <= x2; cx++)
+        cells[CellID(cx, cz)].append(item);
+  }
+  count++;
+  return true;
+}
+
+void OverlayIndex::clear() {
+  cells.clear();
+  large.clear();
+  count = 0;
+}
+
+QList<QSharedPointer<OverlayItem>>
+OverlayIndex::query(const OverlayItem::Point &min,
+                    const OverlayItem::Point &max) const {
+  QList<QSharedPointer<OverlayItem>> ret;
+  for (auto &item : large)
+    if (item->intersects(min, max))
+      ret.append(item);
+
+  int x1 = cell(min.x), x2 = cell(max.x);
+  int z1 = cell(min.z), z2 = cell(max.z);
+  bool single = (x1 == x2) && (z1 == z2);
+  // items spanning several cells must be reported only once
+  QSet<const OverlayItem*> seen;
+  for (int cz = z1; cz <= z2; cz++) {
+    for (int cx = x1; cx <= x2; cx++) {
+      auto it = cells.constFind(CellID(cx, cz));
+      if (it == cells.constEnd())
+        continue;
+      for (auto &item : *it) {
+        if (!item->intersects(min, max))
+          continue;
+        if (!single) {
+          if (seen.contains(item.data()))
+            continue;
+          seen.insert(item.data());
+        }
+        ret.append(item);
+      }
+    }
+  }
+  return ret;
+}
+
+bool OverlayIndex::contains(const Items &items,
+                            const OverlayItem::Point &mid) const {
+  for (auto &it : items) {
+    OverlayItem::Point p = it->midpoint();
+    if ( (p.x == mid.x) && (p.y == mid.y) && (p.z == mid.z) )
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,43 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef OVERLAYINDEX_H_
+#define OVERLAYINDEX_H_
+
+#include <QHash>
+#include <cmath>
+#include <QList>
+#include <QPair>
+#include <QSharedPointer>
+#include "./overlayitem.h"
+
+// spatial index for OverlayItems of one type
+// items are sorted into a grid of cells in the X/Z plane, an item is
+// referenced from every cell its bounding box touches
+class OverlayIndex {
+ public:
+  OverlayIndex() : count(0) {}
+
+  // returns false if an item with the same midpoint is already present
+  bool insert(QSharedPointer<OverlayItem> item);
+  void clear();
+  int size() const { return count; }
+
+  // all items intersecting the given box
+  QList<QSharedPointer<OverlayItem>> query(const OverlayItem::Point &min,
+                                           const OverlayItem::Point &max) const;
+
+ private:
+  typedef QPair<int, int> CellID;
+  typedef QList<QSharedPointer<OverlayItem>> Items;
+
+  static int cell(double v) { return static_cast<int>(floor(v)) >> CELL_SHIFT; }
+  bool contains(const Items &items, const OverlayItem::Point &mid) const;
+
+  static const int CELL_SHIFT = 8;   // 256 blocks per cell
+  static const int MAX_CELLS  = 64;  // larger items are kept in a list
+
+  QHash<CellID, Items> cells;
+  Items large;
+  int count;
+};
+
+#endif  // OVERLAYINDEX_H_
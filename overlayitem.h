@@ -20,9 +20,11 @@ class OverlayItem {
   virtual void draw(double offsetX, double offsetZ, double scale,
                     QPainter *canvas) const = 0;
   virtual Point midpoint() const = 0;
+  // axis aligned bounding box, used for spatial lookups
+  virtual void bounds(Point *min, Point *max) const = 0;
   const QString& type() const {return itemType;}
   const QString& display() const { return itemDescription;}
-  const QVariant& properties() const { return itemProperties;}
+  virtual QVariant properties() const { return itemProperties;}
   const QColor& color() const { return itemColor; }
   const QString& dimension() const { return itemDimension; }
 
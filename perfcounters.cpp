@@ -0,0 +1,81 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include "./perfcounters.h"
+
+PerfCounters::PerfCounters() {
+  reset();
+}
+
+PerfCounters &PerfCounters::Instance() {
+  static PerfCounters singleton;
+  return singleton;
+}
+
+void PerfCounters::record(Stage stage, qint64 nsecs) {
+  Histogram &h = stages[stage];
+  quint32 usecs = static_cast<quint32>(qMin<qint64>(nsecs / 1000, 0xffffffff));
+  int bucket = 32 - qCountLeadingZeroBits(usecs);
+  h.bucket[qMin(bucket, BUCKETS - 1)].fetchAndAddRelaxed(1);
+  h.total.fetchAndAddRelaxed(nsecs);
+  h.count.fetchAndAddRelaxed(1);
+}
+
+void PerfCounters::reset() {
+  for (int s = 0; s < STAGE_COUNT; s++) {
+    stages[s].count.store(0);
+    stages[s].total.store(0);
+    for (int b = 0; b < BUCKETS; b++)
+      stages[s].bucket[b].store(0);
+  }
+  // queue depths are states, not events -> keep them
+  for (int c = cntCacheHit; c <= cntRawMiss; c++)
+    counters[c].store(0);
+}
+
+// upper bound of the bucket containing the given percentile (microseconds)
+int PerfCounters::percentile(const Histogram &h, int count, int percent) {
+  qint64 needed = (static_cast<qint64>(count) * percent + 99) / 100;
+  qint64 seen = 0;
+  for (int b = 0; b < BUCKETS; b++) {
+    seen += h.bucket[b].load();
+    if (seen >= needed)
+      return 1 << b;
+  }
+  return 1 << (BUCKETS - 1);
+}
+
+static QString formatUsecs(double usecs) {
+  if (usecs >= 1000.0)
+    return QString("%1ms").arg(usecs / 1000.0, 0, 'f', 1);
+  return QString("%1us").arg(usecs, 0, 'f', 0);
+}
+
+QStringList PerfCounters::report() const {
+  static const char *names[STAGE_COUNT] = {
+    "io wait", "read", "cpu wait", "decode", "inflate", "parse", "chunk",
+    "render", "redraw", "compose"
+  };
+  QStringList lines;
+  for (int s = 0; s < STAGE_COUNT; s++) {
+    const Histogram &h = stages[s];
+    int count = h.count.load();
+    if (count == 0) {
+      lines << QString("%1 -").arg(names[s], -8);
+      continue;
+    }
+    double avg = h.total.load() / 1000.0 / count;
+    lines << QString("%1 n=%2 avg %3 p50<%4 p99<%5")
+             .arg(names[s], -8)
+             .arg(count)
+             .arg(formatUsecs(avg))
+             .arg(formatUsecs(percentile(h, count, 50)))
+             .arg(formatUsecs(percentile(h, count, 99)));
+  }
+  lines << QString("cache    hit %1 loading %2 miss %3 evict %4")
+           .arg(get(cntCacheHit)).arg(get(cntCacheLoading))
+           .arg(get(cntCacheMiss)).arg(get(cntCacheEvict));
+  lines << QString("raw      hit %1 miss %2")
+           .arg(get(cntRawHit)).arg(get(cntRawMiss));
+  lines << QString("queues   io %1 cpu %2")
+           .arg(get(cntIoQueue)).arg(get(cntCpuQueue));
+  return lines;
+}
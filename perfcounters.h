@@ -0,0 +1,85 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QStringList>
+
+// lightweight instrumentation of the loading and rendering pipeline
+// (always compiled, all updates are single atomic operations)
+class PerfCounters {
+ public:
+  // timed stages of the pipeline
+  enum Stage {
+    stgIoWait,   // time ChunkLoaders wait in the I/O queue
+    stgRead,     // reading compressed data from the Region file
+    stgCpuWait,  // time decoders and renderers wait in the CPU queue
+    stgDecode,   // ChunkDecoder::run, complete
+    stgInflate,  // zlib inflate of NBT data
+    stgParse,    // building the NBT tag tree
+    stgChunk,    // Chunk::load
+    stgRender,   // ChunkRenderer::run
+    stgRedraw,   // MapView::redraw
+    stgCompose,  // MapView::composeFrame
+    STAGE_COUNT
+  };
+  // event counts and queue depths
+  enum Counter {
+    cntCacheHit,      // Chunk found loaded in ChunkCache
+    cntCacheLoading,  // Chunk found in ChunkCache, but still loading
+    cntCacheMiss,     // Chunk had to be loaded
+    cntCacheEvict,    // Chunk dropped from ChunkCache to make room
+    cntRawHit,        // compressed Chunk found in second tier
+    cntRawMiss,       // compressed Chunk read from disk
+    cntIoQueue,       // runnables waiting in the I/O pool
+    cntCpuQueue,      // runnables waiting in the CPU pool
+    COUNTER_COUNT
+  };
+
+  // singleton: access to global usable instance
+  static PerfCounters &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  PerfCounters();
+  ~PerfCounters() {}
+  PerfCounters(const PerfCounters &);
+  PerfCounters &operator=(const PerfCounters &);
+
+ public:
+  void record(Stage stage, qint64 nsecs);
+  void add(Counter counter, int n = 1) { counters[counter].fetchAndAddRelaxed(n); }
+  int  get(Counter counter) const { return counters[counter].load(); }
+  void reset();
+  // human readable summary, one line per stage / counter group
+  QStringList report() const;
+
+ private:
+  // histogram bucket n contains durations below 2^n microseconds
+  static const int BUCKETS = 24;
+  struct Histogram {
+    QAtomicInt count;
+    QAtomicInteger<qint64> total;  // nanoseconds
+    QAtomicInt bucket[BUCKETS];
+  };
+  static int percentile(const Histogram &h, int count, int percent);
+
+  Histogram stages[STAGE_COUNT];
+  QAtomicInt counters[COUNTER_COUNT];
+};
+
+// measures the lifetime of the scope as one sample of the given stage
+class PerfScope {
+ public:
+  explicit PerfScope(PerfCounters::Stage stage) : stage(stage) { timer.start(); }
+  ~PerfScope() { PerfCounters::Instance().record(stage, timer.nsecsElapsed()); }
+ private:
+  PerfScope(const PerfScope &);
+  PerfScope &operator=(const PerfScope &);
+
+  PerfCounters::Stage stage;
+  QElapsedTimer timer;
+};
+
+#endif  // PERFCOUNTERS_H_
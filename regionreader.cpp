@@ -0,0 +1,61 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include <QDebug>
+
+#include "./regionreader.h"
+#include "./chunkcache.h"
+#include "./chunkloader.h"
+#include "./workerpools.h"
+#ifdef HAVE_LIBURING
+#include "./uringregionreader.h"
+#endif
+
+RegionReader *RegionReader::create(Backend backend) {
+#ifdef HAVE_LIBURING
+  if (backend == backendUring) {
+    UringRegionReader *reader = new UringRegionReader();
+    if (reader->isValid())
+      return reader;
+    qWarning() << "io_uring not available, using threads for reading";
+    delete reader;
+  }
+#else
+  if (backend == backendUring)
+    qWarning() << "built without io_uring, using threads for reading";
+#endif
+  return new ThreadRegionReader();
+}
+
+QString RegionReader::regionFile(const QString &path, int cx, int cz) {
+  return path + "/region/r." + QString::number(cx >> 5) + "." +
+      QString::number(cz >> 5) + ".mca";
+}
+
+int RegionReader::sectorOffset(const uchar *header, int cx, int cz,
+                               int *numSectors) {
+  int offset = 4 * ((cx & 31) + (cz & 31) * 32);
+  *numSectors = header[offset + 3];
+  return (header[offset] << 16) | (header[offset + 1] << 8) |
+      header[offset + 2];
+}
+
+bool RegionReader::trimPayload(QByteArray *data) {
+  if (data->size() < 5)
+    return false;
+  const uchar *raw = reinterpret_cast<const uchar*>(data->constData());
+  qint64 length = (quint32(raw[0]) << 24) | (raw[1] << 16) | (raw[2] << 8) |
+                  raw[3];
+  // a broken or partially written Chunk must not reach the decoder
+  if (length <= 0 || length + 4 > data->size())
+    return false;
+  data->truncate(length + 4);
+  return true;
+}
+
+void ThreadRegionReader::request(const QString &path, int cx, int cz,
+                                 int priority) {
+  ChunkCache &cache = ChunkCache::Instance();
+  ChunkLoader *loader = new ChunkLoader(path, cx, cz, priority);
+  QObject::connect(loader, SIGNAL(loaded(int, int)),
+                   &cache, SLOT(gotChunk(int, int)));
+  WorkerPools::Instance().start(WorkerPools::stageIO, loader, priority);
+}
@@ -0,0 +1,39 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef REGIONREADER_H_
+#define REGIONREADER_H_
+
+#include <QByteArray>
+#include <QString>
+
+// reads the compressed data of Chunks from Region files and hands it to
+// the decoding stage of ChunkCache (ChunkCache::chunkRead)
+class RegionReader {
+ public:
+  enum Backend {
+    backendThreads,  // blocking reads in the I/O thread pool
+    backendUring     // asynchronous reads with io_uring (Linux only)
+  };
+  // falls back to threads when the backend is not available
+  static RegionReader *create(Backend backend);
+  virtual ~RegionReader() {}
+
+  virtual void request(const QString &path, int cx, int cz, int priority) = 0;
+  // the Region file was modified, forget everything kept about it
+  virtual void regionChanged(const QString &filename) { Q_UNUSED(filename); }
+
+  // helpers for the Region file format
+  static const int SECTOR_SIZE = 4096;
+  static QString regionFile(const QString &path, int cx, int cz);
+  // first sector of a Chunk (0 if there is none) and its number of sectors
+  static int sectorOffset(const uchar *header, int cx, int cz, int *numSectors);
+  // cut the sector padding behind the stored length
+  static bool trimPayload(QByteArray *data);
+};
+
+// one ChunkLoader job per Chunk in the I/O pool of WorkerPools
+class ThreadRegionReader : public RegionReader {
+ public:
+  void request(const QString &path, int cx, int cz, int priority);
+};
+
+#endif  // REGIONREADER_H_
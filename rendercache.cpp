@@ -0,0 +1,82 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include "./rendercache.h"
+#include "./chunk.h"
+
+RenderKey::RenderKey(int cx, int cz, int depth, int flags, int generation)
+  : cx(cx), cz(cz), depth(depth), flags(flags), generation(generation) {
+}
+bool RenderKey::operator==(const RenderKey &other) const {
+  return (other.cx == cx) && (other.cz == cz) && (other.depth == depth) &&
+         (other.flags == flags) && (other.generation == generation);
+}
+uint qHash(const RenderKey &k) {
+  return ((k.cx << 16) ^ (k.cz & 0xffff)) ^
+         ((k.depth << 8) | (k.flags << 20)) ^ k.generation;
+}
+
+RenderCache::RenderCache() : generation(0) {
+  cache.setMaxCost(RENDER_CACHE_MB * 1024 * 1024 / sizeof(Result));
+}
+
+RenderCache& RenderCache::Instance() {
+  static RenderCache singleton;
+  return singleton;
+}
+
+bool RenderCache::restore(Chunk *chunk, int depth, int flags) {
+  mutex.lock();
+  RenderKey key(chunk->chunkX, chunk->chunkZ, depth, flags, generation);
+  Result *result = cache[key];
+  if (result) {
+    memcpy(chunk->image, result->image, sizeof(chunk->image));
+    memcpy(chunk->depth, result->depth, sizeof(chunk->depth));
+    chunk->renderedAt = depth;
+    chunk->renderedFlags = flags;
+    chunk->renderedGeneration = generation;
+    memcpy(chunk->westEdge, result->westEdge, sizeof(chunk->westEdge));
+    chunk->publishEastEdge();
+  }
+  mutex.unlock();
+  return (result != NULL);
+}
+
+void RenderCache::store(const Chunk &chunk) {
+  Result *result = new Result;
+  memcpy(result->image, chunk.image, sizeof(result->image));
+  memcpy(result->depth, chunk.depth, sizeof(result->depth));
+  memcpy(result->westEdge, chunk.westEdge, sizeof(result->westEdge));
+  mutex.lock();
+  if (chunk.renderedGeneration == generation) {
+    cache.insert(RenderKey(chunk.chunkX, chunk.chunkZ, chunk.renderedAt,
+                           chunk.renderedFlags, chunk.renderedGeneration),
+                 result);
+  } else {
+    delete result;  // rendered with outdated definitions
+  }
+  mutex.unlock();
+}
+
+int RenderCache::getGeneration() const {
+  return generation;
+}
+
+void RenderCache::invalidate() {
+  mutex.lock();
+  generation++;
+  cache.clear();
+  mutex.unlock();
+}
+
+void RenderCache::clear() {
+  mutex.lock();
+  cache.clear();
+  mutex.unlock();
+}
+
+void RenderCache::removeRegion(int rx, int rz) {
+  mutex.lock();
+  for (auto &key : cache.keys())
+    if ((key.cx >> 5) == rx && (key.cz >> 5) == rz)
+      cache.remove(key);
+  mutex.unlock();
+}
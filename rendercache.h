@@ -0,0 +1,60 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef RENDERCACHE_H_
+#define RENDERCACHE_H_
+
+#include <QCache>
+#include <QMutex>
+
+class Chunk;
+
+// RenderKey identifies one rendered variant of a Chunk
+class RenderKey {
+ public:
+  RenderKey(int cx, int cz, int depth, int flags, int generation);
+  bool operator==(const RenderKey &) const;
+  friend uint qHash(const RenderKey &);
+
+  int cx, cz;
+  int depth;
+  int flags;
+  int generation;
+};
+
+// keeps rendered images of Chunks for several depths and view flags
+// (independent of the Chunk data itself)
+class RenderCache {
+ public:
+  // singleton: access to global usable instance
+  static RenderCache &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  RenderCache();
+  ~RenderCache() {}
+  RenderCache(const RenderCache &);
+  RenderCache &operator=(const RenderCache &);
+
+ public:
+  // copy a cached render into the Chunk, returns false when not cached
+  bool restore(Chunk *chunk, int depth, int flags);
+  // remember the current render of the Chunk
+  void store(const Chunk &chunk);
+
+  int getGeneration() const;
+  void invalidate();                   // definitions changed
+  void clear();                        // world or dimension changed
+  void removeRegion(int rx, int rz);   // Region file changed
+
+ private:
+  struct Result {
+    uchar image[16 * 16 * 4];
+    uchar depth[16 * 16];
+    qint16 westEdge[16];
+  };
+  static const int RENDER_CACHE_MB = 64;
+
+  QCache<RenderKey, Result> cache;
+  QMutex mutex;
+  int generation;
+};
+
+#endif  // RENDERCACHE_H_
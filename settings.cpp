@@ -4,6 +4,7 @@
 #include <QDir>
 
 #include "./settings.h"
+#include "./workerpools.h"
 
 Settings::Settings(QWidget *parent) : QDialog(parent) {
   m_ui.setupUi(this);
@@ -43,6 +44,10 @@ Settings::Settings(QWidget *parent) : QDialog(parent) {
   verticalDepth = info.value("verticaldepth", true).toBool();
   fineZoom = info.value("finezoom", false).toBool();
   zoomOut = info.value("zoomout", false).toBool();
+  progressive = info.value("progressive", true).toBool();
+  asyncIO = info.value("asyncio", false).toBool();
+  ioThreads = info.value("iothreads", 0).toInt();
+  cpuThreads = info.value("cputhreads", 0).toInt();
 
   // Set the UI to the current settings' values:
   m_ui.checkBox_AutoUpdate->setChecked(autoUpdate);
@@ -52,6 +57,15 @@ Settings::Settings(QWidget *parent) : QDialog(parent) {
   m_ui.checkBox_VerticalDepth->setChecked(verticalDepth);
   m_ui.checkBox_fine_zoom->setChecked(fineZoom);
   m_ui.checkBox_zoom_out->setChecked(zoomOut);
+  m_ui.checkBox_progressive->setChecked(progressive);
+  m_ui.checkBox_async_io->setChecked(asyncIO);
+  m_ui.spinBox_IoThreads->setValue(ioThreads);
+  m_ui.spinBox_CpuThreads->setValue(cpuThreads);
+
+  connect(m_ui.spinBox_IoThreads, SIGNAL(valueChanged(int)),
+          this, SLOT(setIoThreads(int)));
+  connect(m_ui.spinBox_CpuThreads, SIGNAL(valueChanged(int)),
+          this, SLOT(setCpuThreads(int)));
 }
 
 QString Settings::getDefaultLocation()
@@ -109,6 +123,20 @@ void Settings::toggleVerticalDepth(bool value) {
   emit settingsUpdated();
 }
 
+void Settings::setIoThreads(int count) {
+  ioThreads = count;
+  QSettings info;
+  info.setValue("iothreads", count);
+  WorkerPools::Instance().setThreadCount(WorkerPools::stageIO, count);
+}
+
+void Settings::setCpuThreads(int count) {
+  cpuThreads = count;
+  QSettings info;
+  info.setValue("cputhreads", count);
+  WorkerPools::Instance().setThreadCount(WorkerPools::stageCPU, count);
+}
+
 void Settings::on_checkBox_zoom_out_toggled(bool checked)
 {
   zoomOut = checked;
@@ -124,3 +152,19 @@ void Settings::on_checkBox_fine_zoom_toggled(bool checked)
   info.setValue("finezoom", checked);
   emit settingsUpdated();
 }
+
+void Settings::on_checkBox_progressive_toggled(bool checked)
+{
+  progressive = checked;
+  QSettings info;
+  info.setValue("progressive", checked);
+  emit settingsUpdated();
+}
+
+void Settings::on_checkBox_async_io_toggled(bool checked)
+{
+  asyncIO = checked;
+  QSettings info;
+  info.setValue("asyncio", checked);
+  emit settingsUpdated();
+}
@@ -16,6 +16,10 @@ class Settings : public QDialog {
   QString mcpath;
   bool fineZoom;
   bool zoomOut;
+  bool progressive;
+  bool asyncIO;
+  int ioThreads;   // 0 = adaptive
+  int cpuThreads;  // 0 = adaptive
 
 
   /** Returns the default path to be used for Minecraft location. */
@@ -31,11 +35,17 @@ class Settings : public QDialog {
   void toggleDefaultLocation(bool on);
   void pathChanged(const QString &path);
   void toggleVerticalDepth(bool on);
+  void setIoThreads(int count);
+  void setCpuThreads(int count);
 
   void on_checkBox_zoom_out_toggled(bool checked);
 
   void on_checkBox_fine_zoom_toggled(bool checked);
 
+  void on_checkBox_progressive_toggled(bool checked);
+
+  void on_checkBox_async_io_toggled(bool checked);
+
 private:
   Ui::Settings m_ui;
 };
@@ -0,0 +1,93 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+#include "./tracerecorder.h"
+
+TraceRecorder::TraceRecorder() : enabled(0) {
+}
+
+TraceRecorder::~TraceRecorder() {
+  qDeleteAll(buffers);
+}
+
+TraceRecorder &TraceRecorder::Instance() {
+  static TraceRecorder singleton;
+  return singleton;
+}
+
+void TraceRecorder::start(const QString &filename) {
+  this->filename = filename;
+  clock.start();
+  enabled.store(1);
+}
+
+// each thread appends to its own buffer
+TraceRecorder::Buffer *TraceRecorder::threadBuffer(const char *name) {
+  static thread_local Buffer *buffer = NULL;
+  if (buffer == NULL) {
+    buffer = new Buffer();
+    buffer->events.reserve(4096);
+    mutex.lock();
+    buffer->tid = buffers.size() + 1;
+    // pool threads are named after the first work they do
+    if (QThread::currentThread() == QCoreApplication::instance()->thread())
+      buffer->thread = "GUI";
+    else
+      buffer->thread = QString("%1 %2").arg(name).arg(buffer->tid);
+    buffers.append(buffer);
+    mutex.unlock();
+  }
+  return buffer;
+}
+
+void TraceRecorder::record(const char *name, qint64 begin, int cx, int cz,
+                           bool coords) {
+  Event e;
+  e.name = name;
+  e.begin = begin;
+  e.end = now();
+  e.cx = cx;
+  e.cz = cz;
+  e.coords = coords;
+  Buffer *buffer = threadBuffer(name);
+  buffer->mutex.lock();
+  buffer->events.append(e);
+  buffer->mutex.unlock();
+}
+
+void TraceRecorder::write() {
+  if (!enabled.testAndSetOrdered(1, 0))
+    return;  // not recording or already written
+
+  QFile f(filename);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+    return;
+  QTextStream out(&f);
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  mutex.lock();
+  for (Buffer *buffer : buffers) {
+    buffer->mutex.lock();
+    if (!first)
+      out << ",\n";
+    first = false;
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << buffer->tid << ",\"args\":{\"name\":\"" << buffer->thread << "\"}}";
+    for (const Event &e : buffer->events) {
+      out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+          << buffer->tid
+          << ",\"ts\":" << QString::number(e.begin / 1000.0, 'f', 3)
+          << ",\"dur\":" << QString::number((e.end - e.begin) / 1000.0, 'f', 3);
+      if (e.coords)
+        out << ",\"args\":{\"cx\":" << e.cx << ",\"cz\":" << e.cz << "}";
+      out << "}";
+    }
+    buffer->events.clear();
+    buffer->mutex.unlock();
+  }
+  mutex.unlock();
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
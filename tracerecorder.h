@@ -0,0 +1,83 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef TRACERECORDER_H_
+#define TRACERECORDER_H_
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// records the loading pipeline as Chrome trace JSON
+// (viewable in chrome://tracing or Perfetto), enabled with --trace <file>
+class TraceRecorder {
+ public:
+  // singleton: access to global usable instance
+  static TraceRecorder &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  TraceRecorder();
+  ~TraceRecorder();
+  TraceRecorder(const TraceRecorder &);
+  TraceRecorder &operator=(const TraceRecorder &);
+
+ public:
+  // has to be called before any worker thread is started
+  void start(const QString &filename);
+  bool isEnabled() const { return enabled.load(); }
+  qint64 now() const { return clock.nsecsElapsed(); }
+  // one complete event (begin and duration), name has to be a literal
+  void record(const char *name, qint64 begin, int cx, int cz, bool coords);
+  // write all recorded events, called once at exit
+  void write();
+
+ private:
+  struct Event {
+    const char *name;
+    qint64 begin, end;  // nanoseconds since start()
+    int cx, cz;
+    bool coords;
+  };
+  // events of one thread, the mutex is only contended during write()
+  struct Buffer {
+    int tid;
+    QString thread;
+    QMutex mutex;
+    QVector<Event> events;
+  };
+  Buffer *threadBuffer(const char *name);
+
+  QAtomicInt enabled;
+  QString filename;
+  QElapsedTimer clock;
+  QMutex mutex;           // guards the list of buffers
+  QList<Buffer *> buffers;
+};
+
+// records the lifetime of the scope as one trace event
+class TraceScope {
+ public:
+  explicit TraceScope(const char *name)
+    : name(name), cx(0), cz(0), coords(false) { begin(); }
+  TraceScope(const char *name, int cx, int cz)
+    : name(name), cx(cx), cz(cz), coords(true) { begin(); }
+  ~TraceScope() {
+    if (start >= 0)
+      TraceRecorder::Instance().record(name, start, cx, cz, coords);
+  }
+ private:
+  void begin() {
+    TraceRecorder &trace = TraceRecorder::Instance();
+    start = trace.isEnabled() ? trace.now() : -1;
+  }
+  TraceScope(const TraceScope &);
+  TraceScope &operator=(const TraceScope &);
+
+  const char *name;
+  int cx, cz;
+  bool coords;
+  qint64 start;
+};
+
+#endif  // TRACERECORDER_H_
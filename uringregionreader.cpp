@@ -0,0 +1,294 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifdef HAVE_LIBURING
+
+#include <QDebug>
+#include <QFile>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./uringregionreader.h"
+#include "./chunkcache.h"
+#include "./perfcounters.h"
+#include "./tracerecorder.h"
+
+UringRegionReader::UringRegionReader()
+  : valid(false)
+  , stopping(false)
+  , active(0)
+  , inFlight(0) {
+  valid = (io_uring_queue_init(QUEUE_DEPTH, &ring, 0) == 0);
+  if (valid)
+    start();
+}
+
+UringRegionReader::~UringRegionReader() {
+  if (!valid)
+    return;
+  mutex.lock();
+  stopping = true;
+  wakeup.wakeAll();
+  mutex.unlock();
+  wait();
+  io_uring_queue_exit(&ring);
+  qDeleteAll(visible);
+  qDeleteAll(prefetched);
+  for (Region *region : regions) {
+    ::close(region->fd);
+    delete region;
+  }
+}
+
+void UringRegionReader::request(const QString &path, int cx, int cz,
+                                int priority) {
+  Request *r = new Request();
+  r->path = path;
+  r->filename = regionFile(path, cx, cz);
+  r->cx = cx;
+  r->cz = cz;
+  r->priority = priority;
+  r->region = NULL;
+  r->header = false;
+  r->traceBegin = 0;
+  r->timer.start();
+  PerfCounters::Instance().add(PerfCounters::cntIoQueue);
+
+  mutex.lock();
+  if (priority >= 0)
+    visible.enqueue(r);
+  else
+    prefetched.enqueue(r);
+  wakeup.wakeOne();
+  mutex.unlock();
+}
+
+void UringRegionReader::regionChanged(const QString &filename) {
+  mutex.lock();
+  changed.insert(filename);
+  mutex.unlock();
+}
+
+void UringRegionReader::run() {
+  int errors = 0;  // consecutive failures of the ring
+  forever {
+    // take as many new requests as there is room in the ring
+    QList<Request *> starting;
+    QSet<QString> outdated;
+    mutex.lock();
+    while (!stopping && active == 0 && changed.isEmpty() &&
+           visible.isEmpty() && prefetched.isEmpty())
+      wakeup.wait(&mutex);
+    if (stopping && active == 0) {
+      mutex.unlock();
+      break;
+    }
+    outdated.swap(changed);
+    while (!stopping && active + starting.size() < QUEUE_DEPTH &&
+           !(visible.isEmpty() && prefetched.isEmpty()))
+      starting.append(visible.isEmpty() ? prefetched.dequeue()
+                                        : visible.dequeue());
+    mutex.unlock();
+
+    for (const QString &filename : outdated) {
+      Region *region = regions.take(filename);
+      if (region) {
+        region->retired = true;
+        if (region->users == 0)
+          dropRegion(region);
+      }
+    }
+    for (Request *r : starting)
+      begin(r);
+    if (inFlight == 0)
+      continue;
+
+    // wait for at least one read, then handle everything that is done
+    int ret = io_uring_submit_and_wait(&ring, 1);
+    if (ret < 0 && ret != -EINTR) {
+      // completions already queued are handled below, which usually
+      // resolves the error; otherwise don't spin while the kernel recovers
+      if (errors == 0)
+        qWarning() << "io_uring_submit_and_wait failed:" << strerror(-ret);
+      errors = qMin(errors + 1, 16);
+    } else {
+      errors = 0;
+    }
+    struct io_uring_cqe *cqe;
+    bool progress = false;
+    while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+      Request *r = static_cast<Request *>(io_uring_cqe_get_data(cqe));
+      int result = cqe->res;
+      io_uring_cqe_seen(&ring, cqe);
+      inFlight--;
+      progress = true;
+      complete(r, result);  // might queue the next read of this Request
+    }
+    if (errors > 0 && !progress)
+      QThread::msleep(qMin(1 << errors, MAX_BACKOFF_MS));
+  }
+}
+
+void UringRegionReader::begin(Request *r) {
+  PerfCounters &perf = PerfCounters::Instance();
+  perf.add(PerfCounters::cntIoQueue, -1);
+  perf.record(PerfCounters::stgIoWait, r->timer.nsecsElapsed());
+  r->timer.start();
+  TraceRecorder &trace = TraceRecorder::Instance();
+  if (trace.isEnabled())
+    r->traceBegin = trace.now();
+  active++;
+
+  // Region files stay open, their header is read only once
+  Region *region = regions.value(r->filename);
+  if (region == NULL) {
+    int fd = ::open(QFile::encodeName(r->filename).constData(),
+                    O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {  // no chunks in this region
+      ChunkCache &cache = ChunkCache::Instance();
+      cache.setRegionMissing(r->path, r->cx >> 5, r->cz >> 5);
+      cache.removeChunk(r->path, r->cx, r->cz);
+      fail(r);
+      return;
+    }
+    trimRegions();
+    region = new Region();
+    region->filename = r->filename;
+    region->fd = fd;
+    region->loaded = false;
+    region->retired = false;
+    region->users = 0;
+    regions.insert(r->filename, region);
+  }
+  r->region = region;
+  region->users++;
+
+  if (region->loaded) {
+    readChunk(r);
+    return;
+  }
+  region->waiting.append(r);
+  if (region->waiting.size() == 1) {  // first one reads the header
+    r->header = true;
+    region->header.resize(SECTOR_SIZE);
+    if (!queueRead(r, region->header.data(), 0, SECTOR_SIZE)) {
+      region->waiting.clear();
+      fail(r);
+    }
+  }
+}
+
+void UringRegionReader::readChunk(Request *r) {
+  ChunkCache &cache = ChunkCache::Instance();
+  const uchar *header =
+      reinterpret_cast<const uchar *>(r->region->header.constData());
+  int numSectors;
+  int coffset = sectorOffset(header, r->cx, r->cz, &numSectors);
+  if (coffset == 0) {  // no chunk
+    cache.removeChunk(r->path, r->cx, r->cz);
+    fail(r);
+    return;
+  }
+  r->header = false;
+  r->buffer.resize(numSectors * SECTOR_SIZE);
+  if (!queueRead(r, r->buffer.data(),
+                 static_cast<qint64>(coffset) * SECTOR_SIZE,
+                 r->buffer.size()))
+    fail(r);
+}
+
+bool UringRegionReader::queueRead(Request *r, void *buffer, qint64 offset,
+                                  int length) {
+  struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+  if (sqe == NULL) {
+    // submission queue is full, hand it to the kernel to make room
+    io_uring_submit(&ring);
+    sqe = io_uring_get_sqe(&ring);
+    if (sqe == NULL)
+      return false;
+  }
+  io_uring_prep_read(sqe, r->region->fd, buffer, length, offset);
+  io_uring_sqe_set_data(sqe, r);
+  inFlight++;
+  return true;
+}
+
+void UringRegionReader::complete(Request *r, int result) {
+  if (r->header) {
+    Region *region = r->region;
+    QList<Request *> waiting;
+    waiting.swap(region->waiting);
+    if (result < SECTOR_SIZE) {  // incomplete region file
+      for (Request *w : waiting)
+        fail(w);
+      return;
+    }
+    region->loaded = true;
+    ChunkCache::Instance().setRegionHeader(
+        r->path, r->cx >> 5, r->cz >> 5,
+        reinterpret_cast<const uchar *>(region->header.constData()),
+        r->filename);
+    for (Request *w : waiting)
+      readChunk(w);
+    return;
+  }
+
+  if (result < 5) {  // error or not even the length and compression
+    fail(r);
+    return;
+  }
+  r->buffer.resize(result);
+  if (!trimPayload(&r->buffer)) {
+    fail(r);
+    return;
+  }
+  PerfCounters::Instance().record(PerfCounters::stgRead, r->timer.nsecsElapsed());
+  TraceRecorder &trace = TraceRecorder::Instance();
+  if (trace.isEnabled())
+    trace.record("read", r->traceBegin, r->cx, r->cz, true);
+  // decoding continues in the CPU pool
+  ChunkCache::Instance().chunkRead(r->path, r->cx, r->cz, r->buffer,
+                                   r->priority);
+  release(r);
+}
+
+void UringRegionReader::fail(Request *r) {
+  ChunkCache::Instance().chunkUnavailable(r->cx, r->cz);
+  release(r);
+}
+
+void UringRegionReader::release(Request *r) {
+  Region *region = r->region;
+  if (region != NULL) {
+    region->users--;
+    if (region->users == 0 && (region->retired || !region->loaded)) {
+      // a changed file or a broken header is opened again on next use
+      if (!region->retired)
+        regions.remove(region->filename);
+      dropRegion(region);
+    }
+  }
+  active--;
+  delete r;
+}
+
+void UringRegionReader::dropRegion(Region *region) {
+  ::close(region->fd);
+  delete region;
+}
+
+// close idle Regions, e.g. of a previous world
+void UringRegionReader::trimRegions() {
+  if (regions.size() <= MAX_OPEN_REGIONS)
+    return;
+  for (auto it = regions.begin(); it != regions.end();) {
+    if (it.value()->users == 0) {
+      dropRegion(it.value());
+      it = regions.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+#endif  // HAVE_LIBURING
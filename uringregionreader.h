@@ -0,0 +1,82 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef URINGREGIONREADER_H_
+#define URINGREGIONREADER_H_
+
+#ifdef HAVE_LIBURING
+
+#include <liburing.h>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+#include "./regionreader.h"
+
+// keeps many sector reads in flight on one thread using io_uring,
+// every completed Chunk is passed to the decoding stage right away
+class UringRegionReader : public QThread, public RegionReader {
+ public:
+  UringRegionReader();
+  ~UringRegionReader();
+
+  bool isValid() const { return valid; }
+  void request(const QString &path, int cx, int cz, int priority);
+  void regionChanged(const QString &filename);
+
+ protected:
+  void run();
+
+ private:
+  struct Request;
+  // open Region file with its header, shared by all Requests into it
+  struct Region {
+    QString filename;
+    int fd;
+    QByteArray header;         // Chunk offsets, once loaded
+    bool loaded;
+    bool retired;              // file changed, close when unused
+    int users;                 // Requests using the file descriptor
+    QList<Request *> waiting;  // for the header
+  };
+  struct Request {
+    QString path;
+    QString filename;
+    int cx, cz;
+    int priority;
+    Region *region;
+    bool header;         // reading the Region header, else the Chunk
+    QByteArray buffer;
+    QElapsedTimer timer;  // queue wait, then read time
+    qint64 traceBegin;
+  };
+  void begin(Request *r);
+  void readChunk(Request *r);
+  void complete(Request *r, int result);
+  bool queueRead(Request *r, void *buffer, qint64 offset, int length);
+  void fail(Request *r);
+  void release(Request *r);
+  void dropRegion(Region *region);
+  void trimRegions();
+
+  static const int QUEUE_DEPTH = 64;        // Requests in progress
+  static const int MAX_OPEN_REGIONS = 256;  // idle Regions kept open
+  static const int MAX_BACKOFF_MS = 100;    // after errors of the ring
+
+  struct io_uring ring;
+  bool valid;
+  bool stopping;
+  int active;                     // only used by the reader thread
+  int inFlight;                   // only used by the reader thread
+  QHash<QString, Region *> regions;  // only used by the reader thread
+  QMutex mutex;                   // guards the queues, changed and stopping
+  QWaitCondition wakeup;
+  QQueue<Request *> visible;      // requested for display
+  QQueue<Request *> prefetched;   // speculative, read when idle
+  QSet<QString> changed;          // Region files to forget
+};
+
+#endif  // HAVE_LIBURING
+
+#endif  // URINGREGIONREADER_H_
@@ -0,0 +1,102 @@
+/** Copyright (c) 2026, Minutor contributors */
+#include <QSettings>
+#include <QThread>
+
+#include "./workerpools.h"
+#include "./perfcounters.h"
+
+WorkerPools::WorkerPools() {
+  int cores = QThread::idealThreadCount();
+  QSettings settings;
+
+  // disk access: start with half the cores (as before), but allow many
+  // more threads when the storage is latency bound (network drives)
+  Pool &io = pools[stageIO];
+  io.minimum = qMax(2, cores / 2);
+  io.maximum = 4 * cores;
+  io.threads.setMaxThreadCount(io.minimum);
+  setThreadCount(stageIO, settings.value("iothreads", 0).toInt());
+
+  // decoding and rendering: never more threads than cores
+  Pool &cpu = pools[stageCPU];
+  cpu.minimum = qMax(1, cores / 2);
+  cpu.maximum = cores;
+  cpu.threads.setMaxThreadCount(cores);
+  setThreadCount(stageCPU, settings.value("cputhreads", 0).toInt());
+
+  timer.setInterval(ADAPT_INTERVAL_MS);
+  connect(&timer, SIGNAL(timeout()),
+          this,   SLOT(adapt()));
+  timer.start();
+}
+
+WorkerPools::~WorkerPools() {
+  for (int s = 0; s < STAGE_COUNT; s++)
+    pools[s].threads.waitForDone();
+}
+
+WorkerPools &WorkerPools::Instance() {
+  static WorkerPools singleton;
+  return singleton;
+}
+
+void WorkerPools::start(Stage stage, QRunnable *runnable, int priority) {
+  pools[stage].queued.fetchAndAddRelaxed(1);
+  PerfCounters::Instance().add(stage == stageIO ? PerfCounters::cntIoQueue
+                                                : PerfCounters::cntCpuQueue);
+  pools[stage].threads.start(runnable, priority);
+}
+
+void WorkerPools::reportWait(Stage stage, qint64 nsecs) {
+  Pool &pool = pools[stage];
+  pool.queued.fetchAndAddRelaxed(-1);
+  pool.wait.fetchAndAddRelaxed(nsecs);
+  pool.samples.fetchAndAddRelaxed(1);
+  PerfCounters &perf = PerfCounters::Instance();
+  if (stage == stageIO) {
+    perf.add(PerfCounters::cntIoQueue, -1);
+    perf.record(PerfCounters::stgIoWait, nsecs);
+  } else {
+    perf.add(PerfCounters::cntCpuQueue, -1);
+    perf.record(PerfCounters::stgCpuWait, nsecs);
+  }
+}
+
+void WorkerPools::setThreadCount(Stage stage, int count) {
+  Pool &pool = pools[stage];
+  pool.fixed = qMax(0, count);
+  if (pool.fixed > 0)
+    pool.threads.setMaxThreadCount(pool.fixed);
+  else  // back to adaptive sizing, starting inside its range
+    pool.threads.setMaxThreadCount(qBound(pool.minimum,
+                                          pool.threads.maxThreadCount(),
+                                          pool.maximum));
+}
+
+int WorkerPools::getThreadCount(Stage stage) const {
+  return pools[stage].threads.maxThreadCount();
+}
+
+void WorkerPools::waitForDone(Stage stage) {
+  pools[stage].threads.waitForDone();
+}
+
+// grow a pool quickly while its runnables wait long in the queue,
+// shrink it slowly when they hardly wait at all
+void WorkerPools::adapt() {
+  for (int s = 0; s < STAGE_COUNT; s++) {
+    Pool &pool = pools[s];
+    qint64 wait = pool.wait.fetchAndStoreRelaxed(0);
+    int samples = pool.samples.fetchAndStoreRelaxed(0);
+    if (pool.fixed > 0)
+      continue;
+
+    int threads = pool.threads.maxThreadCount();
+    qint64 average = samples > 0 ? wait / samples / 1000 : 0;  // us
+    if (average > WAIT_GROW_US && pool.queued.load() > 0)
+      threads = qMin(threads * 2, pool.maximum);
+    else if (samples > 0 && average < WAIT_SHRINK_US)
+      threads = qMax(threads - 1, pool.minimum);
+    pool.threads.setMaxThreadCount(threads);
+  }
+}
@@ -0,0 +1,62 @@
+/** Copyright (c) 2026, Minutor contributors */
+#ifndef WORKERPOOLS_H_
+#define WORKERPOOLS_H_
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QThreadPool>
+#include <QTimer>
+
+// thread pools of the two stage Chunk pipeline:
+// a latency bound stage reading Region files and a CPU bound stage
+// decoding and rendering Chunks, both adapt to the measured queue waits
+class WorkerPools : public QObject {
+  Q_OBJECT
+
+ public:
+  enum Stage {
+    stageIO,   // reading compressed Chunk data from disk
+    stageCPU,  // decoding and rendering Chunks
+    STAGE_COUNT
+  };
+
+  // singleton: access to global usable instance
+  static WorkerPools &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  WorkerPools();
+  ~WorkerPools();
+  WorkerPools(const WorkerPools &);
+  WorkerPools &operator=(const WorkerPools &);
+
+ public:
+  void start(Stage stage, QRunnable *runnable, int priority = 0);
+  // called by a runnable when it starts, with the time spent in the queue
+  void reportWait(Stage stage, qint64 nsecs);
+  // fixed number of threads, 0 adapts to the measured queue waits
+  void setThreadCount(Stage stage, int count);
+  int  getThreadCount(Stage stage) const;
+  void waitForDone(Stage stage);
+
+ private slots:
+  void adapt();
+
+ private:
+  static const int ADAPT_INTERVAL_MS = 500;
+  static const int WAIT_GROW_US = 20000;   // add a thread above this wait
+  static const int WAIT_SHRINK_US = 2000;  // remove a thread below this wait
+
+  struct Pool {
+    QThreadPool threads;
+    int fixed;                     // from Settings or command line, 0 = adaptive
+    int minimum, maximum;          // range for adaptive sizing
+    QAtomicInteger<qint64> wait;   // summed queue wait since last adaption
+    QAtomicInt samples;            // runnables started since last adaption
+    QAtomicInt queued;             // runnables waiting in the queue
+  };
+  Pool pools[STAGE_COUNT];
+  QTimer timer;
+};
+
+#endif  // WORKERPOOLS_H_
@@ -104,6 +104,7 @@ void WorldSave::run() {
   double maximum = (bottom + 1 - top) * (right + 1 - left);
   double step = 0.0;
   for (int z = top; z <= bottom; z++) {
+    QSharedPointer<Chunk> west;  // previous Chunk in this row
     for (int x = left; x <= right; x++, step += 1.0) {
       emit progress(tr("Rendering world"), step / maximum);
       int rx = x >> 5;
@@ -112,6 +113,7 @@ void WorldSave::run() {
               QString::number(rz) + ".mca");
       if (!f.open(QIODevice::ReadOnly)) {
         blankChunk(scanlines, width * 4 + 1, x - left);
+        west.reset();
         continue;
       }
       uchar *header = f.map(0, 4096);
@@ -123,14 +125,15 @@ void WorldSave::run() {
       if (coffset == 0) {
         // no chunk here
         blankChunk(scanlines, width * 4 + 1, x - left);
+        west.reset();
       } else {
         uchar *raw = f.map(coffset * 4096, numSectors * 4096);
         NBT nbt(raw);
         QSharedPointer<Chunk> chunk(new Chunk());
         chunk->load(nbt);
         f.unmap(raw);
-        drawChunk(scanlines, width * 4 + 1, x - left, chunk);
-        chunk.reset();
+        drawChunk(scanlines, width * 4 + 1, x - left, chunk, west);
+        west = chunk;
       }
       f.close();
     }
@@ -289,7 +292,8 @@ void WorldSave::blankChunk(uchar *scanlines, int stride, int x) {
     memset(scanlines + offset, 0, 16 * 4);
 }
 
-void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk) {
+void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk,
+                          QSharedPointer<Chunk> west) {
   // calculate attenuation
   float attenuation = 1.0f;
   if (this->regionChecker && static_cast<int>(floor(chunk->chunkX / 32.0f) +
@@ -299,7 +303,9 @@ void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Ch
     attenuation *= 0.9f;
 
   // render chunk with current settings
+  // (our Chunks are not in the ChunkCache, the neighbour is the previous one)
   ChunkRenderer renderer(chunk->chunkX, chunk->chunkZ, map->getDepth(), map->getFlags());
+  renderer.setExport(west);
   renderer.renderChunk(chunk);
   // we can't memcpy each scanline because it's in BGRA format.
   int offset = x * 16 * 4 + 1;
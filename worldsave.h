@@ -25,7 +25,8 @@ class WorldSave : public QObject, public QRunnable {
 
  private:
   void blankChunk(uchar *scanlines, int stride, int x);
-  void drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk);
+  void drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk,
+                 QSharedPointer<Chunk> west);
 
   QString filename;
   MapView *map;